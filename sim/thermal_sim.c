@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Host-side thermal plant simulator.
+ *
+ * Links the firmware's real control pass (fan_zone.c, fan_curve.c) against
+ * a first-order thermal model of the cooled part, and replaces the DS18B20
+ * internal sensor and PWM drivers with the model. Every control period the
+ * model is advanced in closed form, the lagged and noisy sensor reading is
+ * handed to fan_zone_update() and the resulting duty drives the fan.
+ *
+ * Model:
+ *   C dT/dt = P(t) - (G_passive + G_fan * airflow(duty)) * (T - T_ambient)
+ *   airflow(duty) = duty, or 0 below the fan's start duty (stall)
+ *   sensor = first-order lag of T, plus Gaussian noise, in 1/16 °C steps
+ *
+ * Reported per run: settling time and overshoot after each load step, peak
+ * temperature, duty-weighted fan energy, the number of PWM changes and of
+ * sensor reads (fewer with -DDS18B20_ALARM_MODE=1).
+ *
+ * Build and run from the repository root:
+ *   make sim && ./thermal_sim -p square -H 40 -t 1000
+ */
+
+#include "ds18b20.h"
+#include "fan_zone.h"
+#include "temp_sensor.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_SUBSTEPS (4)           // Model steps per control period
+#define SIM_SETTLE_BAND (0.5)      // °C around the final value
+#define SIM_STEADY_FRACTION (0.1)  // Tail of a segment taken as steady state
+
+// Heat load profiles
+enum {
+  SIM_PROFILE_CONST = 0, // P_low throughout
+  SIM_PROFILE_STEP = 1,  // P_low, then P_high from half time
+  SIM_PROFILE_SQUARE = 2, // P_low / P_high, alternating every half period
+  SIM_PROFILE_RAMP = 3,  // P_low to P_high and back, triangle of period
+};
+
+typedef struct {
+  double hours;         // Simulated time (h)
+  double period;        // Control period (s), firmware delay + conversion
+  double ambient;       // Ambient temperature (°C)
+  double capacity;      // Heat capacity (J/K)
+  double g_passive;     // Conductance with the fan stopped (W/K)
+  double g_fan;         // Added conductance at 100% airflow (W/K)
+  double fan_start;     // Duty below which the fan stalls (0-1)
+  double fan_power;     // Fan power at 100% duty (W)
+  double sensor_tau;    // Sensor time constant (s)
+  double noise;         // Sensor noise, standard deviation (°C)
+  int profile;          // SIM_PROFILE_*
+  double p_low;         // Low heat load (W)
+  double p_high;        // High heat load (W)
+  double profile_period; // Profile period (s)
+  unsigned seed;        // Noise seed
+  int csv;              // Print one CSV line instead of a report
+} sim_params_t;
+
+typedef struct {
+  double temp;   // Die temperature (°C)
+  double sensor; // Sensor temperature before noise (°C)
+  uint16_t duty; // Fan duty from the controller (0-65535)
+  uint32_t rng;  // xorshift32 state
+} sim_plant_t;
+
+typedef struct {
+  double *trace;     // Die temperature of the current load segment
+  size_t count;      // Samples in trace
+  size_t capacity;   // Allocated samples
+  int active;        // A load step has happened (skip the initial warm-up)
+  int rising;        // Segment started with a load increase
+  // Totals over all load steps
+  unsigned steps;
+  double overshoot_max;
+  double overshoot_sum;
+  double settle_max;
+  double settle_sum;
+} sim_steps_t;
+
+static sim_plant_t sim_plant;
+static double sim_noise = 0.0; // Sensor noise, standard deviation (°C)
+static int16_t sim_reading;     // Result of the last conversion, 1/16 °C
+static unsigned long sim_reads; // Scratchpad reads
+
+/*
+ * Firmware driver replacements, fed from the plant model.
+ */
+
+uint8_t ds18b20_scan(void) { return 1; }
+
+uint8_t ds18b20_count(void) { return 1; }
+
+/**
+ * Uniform random number in (0, 1].
+ */
+static double sim_uniform(void) {
+  uint32_t x = sim_plant.rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sim_plant.rng = x;
+  return (x + 1.0) / 4294967296.0;
+}
+
+/**
+ * Gaussian random number with standard deviation 1 (Box-Muller).
+ */
+static double sim_gauss(void) {
+  return sqrt(-2.0 * log(sim_uniform())) * cos(6.283185307179586 *
+                                               sim_uniform());
+}
+
+uint8_t ds18b20_start_conversion(void) {
+  double reading = sim_plant.sensor + sim_noise * sim_gauss();
+  sim_reading = (int16_t)lround(reading * 16.0); // 1/16 °C steps
+  return 1;
+}
+
+void ds18b20_wait_conversion(void) {}
+
+#if DS18B20_ALARM_MODE
+static int8_t sim_alarm_low, sim_alarm_high; // TL / TH
+static unsigned sim_alarm_passes;
+
+uint8_t ds18b20_alarm_search(void) {
+  if (++sim_alarm_passes >= DS18B20_ALARM_REFRESH) {
+    sim_alarm_passes = 0;
+    return 0xFF;
+  }
+  int8_t t = (int8_t)(sim_reading >> 4);
+  return t <= sim_alarm_low || t >= sim_alarm_high;
+}
+
+void ds18b20_set_alarm(uint8_t index, int8_t low, int8_t high) {
+  (void)index;
+  sim_alarm_low = low;
+  sim_alarm_high = high;
+}
+#endif
+
+int16_t ds18b20_read_sensor_raw(uint8_t index) {
+  (void)index;
+  sim_reads++;
+  return sim_reading;
+}
+
+int16_t temp_sensor_read_celsius(void) {
+  return (int16_t)lround(sim_plant.sensor);
+}
+
+void pwm_channel_set16(uint8_t channel, uint16_t duty) {
+  if (channel == 0) {
+    sim_plant.duty = duty;
+  }
+}
+
+/*
+ * Simulation
+ */
+
+/**
+ * Heat load at time t.
+ */
+static double sim_load(const sim_params_t *p, double t, double end) {
+  double phase;
+
+  switch (p->profile) {
+  case SIM_PROFILE_STEP:
+    return (t < end / 2) ? p->p_low : p->p_high;
+  case SIM_PROFILE_SQUARE:
+    phase = fmod(t, p->profile_period) / p->profile_period;
+    return (phase < 0.5) ? p->p_low : p->p_high;
+  case SIM_PROFILE_RAMP:
+    phase = fmod(t, p->profile_period) / p->profile_period;
+    phase = (phase < 0.5) ? 2 * phase : 2 - 2 * phase;
+    return p->p_low + (p->p_high - p->p_low) * phase;
+  default:
+    return p->p_low;
+  }
+}
+
+/**
+ * Close the current load segment: measure overshoot and settling time
+ * against the segment's steady-state temperature.
+ */
+static void sim_steps_close(sim_steps_t *s, const sim_params_t *p) {
+  if (!s->active || s->count < 10) {
+    s->count = 0;
+    return; // Too short to have a steady state
+  }
+
+  size_t tail = (size_t)(s->count * SIM_STEADY_FRACTION);
+  double final = 0;
+  for (size_t i = s->count - tail; i < s->count; i++) {
+    final += s->trace[i];
+  }
+  final /= tail;
+
+  double overshoot = 0;
+  size_t settled = 0;
+  for (size_t i = 0; i < s->count; i++) {
+    double excess = s->rising ? s->trace[i] - final : final - s->trace[i];
+    if (excess > overshoot) {
+      overshoot = excess;
+    }
+    if (fabs(s->trace[i] - final) > SIM_SETTLE_BAND) {
+      settled = i + 1; // Last sample outside the band
+    }
+  }
+
+  double settle = settled * p->period;
+  s->steps++;
+  s->overshoot_sum += overshoot;
+  s->settle_sum += settle;
+  if (overshoot > s->overshoot_max)
+    s->overshoot_max = overshoot;
+  if (settle > s->settle_max)
+    s->settle_max = settle;
+
+  s->count = 0;
+}
+
+static void sim_steps_add(sim_steps_t *s, double temp) {
+  if (s->count == s->capacity) {
+    s->capacity = s->capacity ? s->capacity * 2 : 1024;
+    s->trace = realloc(s->trace, s->capacity * sizeof(*s->trace));
+    if (!s->trace) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  s->trace[s->count++] = temp;
+}
+
+static void sim_usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -t HOURS    simulated time (default 24)\n"
+          "  -p PROFILE  const | step | square | ramp (default square)\n"
+          "  -L WATTS    low heat load (default 5)\n"
+          "  -H WATTS    high heat load (default 25)\n"
+          "  -T SECONDS  profile period (default 1200)\n"
+          "  -a CELSIUS  ambient temperature (default 22)\n"
+          "  -C J_PER_K  heat capacity (default 300)\n"
+          "  -g W_PER_K  passive conductance (default 0.4)\n"
+          "  -G W_PER_K  fan conductance at 100%% (default 2.5)\n"
+          "  -f DUTY     fan stall duty, 0-1 (default 0.2)\n"
+          "  -w WATTS    fan power at 100%% (default 3)\n"
+          "  -s SECONDS  sensor time constant (default 8)\n"
+          "  -n CELSIUS  sensor noise, std dev (default 0.1)\n"
+          "  -d SECONDS  control period (default 2.75)\n"
+          "  -r SEED     noise seed (default 1)\n"
+          "  -h          this help\n"
+          "  -c          one CSV line: overshoot_max,overshoot_mean,\n"
+          "              settle_max,settle_mean,peak,energy_wh,pwm_changes\n",
+          argv0);
+}
+
+static int sim_parse_profile(const char *name) {
+  if (!strcmp(name, "const"))
+    return SIM_PROFILE_CONST;
+  if (!strcmp(name, "step"))
+    return SIM_PROFILE_STEP;
+  if (!strcmp(name, "square"))
+    return SIM_PROFILE_SQUARE;
+  if (!strcmp(name, "ramp"))
+    return SIM_PROFILE_RAMP;
+  return -1;
+}
+
+int main(int argc, char **argv) {
+  sim_params_t p = {24,  2.75, 22,  300, 0.4, 2.5, 0.2, 3,
+                    8,   0.1,  SIM_PROFILE_SQUARE, 5, 25, 1200,
+                    1,   0};
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:p:L:H:T:a:C:g:G:f:w:s:n:d:r:ch")) != -1) {
+    switch (opt) {
+    case 't': p.hours = atof(optarg); break;
+    case 'p':
+      p.profile = sim_parse_profile(optarg);
+      if (p.profile < 0) {
+        sim_usage(argv[0]);
+        return 2;
+      }
+      break;
+    case 'L': p.p_low = atof(optarg); break;
+    case 'H': p.p_high = atof(optarg); break;
+    case 'T': p.profile_period = atof(optarg); break;
+    case 'a': p.ambient = atof(optarg); break;
+    case 'C': p.capacity = atof(optarg); break;
+    case 'g': p.g_passive = atof(optarg); break;
+    case 'G': p.g_fan = atof(optarg); break;
+    case 'f': p.fan_start = atof(optarg); break;
+    case 'w': p.fan_power = atof(optarg); break;
+    case 's': p.sensor_tau = atof(optarg); break;
+    case 'n': p.noise = atof(optarg); break;
+    case 'd': p.period = atof(optarg); break;
+    case 'r': p.seed = (unsigned)strtoul(optarg, NULL, 0); break;
+    case 'c': p.csv = 1; break;
+    case 'h':
+      sim_usage(argv[0]);
+      return 0;
+    default:
+      sim_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (p.period <= 0 || p.capacity <= 0 || p.g_passive <= 0 ||
+      p.sensor_tau <= 0 || p.profile_period <= 0) {
+    sim_usage(argv[0]);
+    return 2;
+  }
+
+  double end = p.hours * 3600.0;
+  double h = p.period / SIM_SUBSTEPS;
+  double sensor_k = 1.0 - exp(-h / p.sensor_tau);
+
+  sim_noise = p.noise;
+  sim_plant.temp = p.ambient;
+  sim_plant.sensor = p.ambient;
+  sim_plant.rng = p.seed ? p.seed : 1;
+  sim_plant.duty = 0;
+
+  sim_steps_t steps;
+  memset(&steps, 0, sizeof(steps));
+
+  double energy = 0;   // Fan energy (J)
+  double peak = p.ambient;
+  unsigned long changes = 0;
+  uint16_t last_duty = 0;
+  double last_load = sim_load(&p, 0, end);
+
+  fan_zone_init();
+
+  clock_t started = clock();
+
+  for (double t = 0; t < end; t += p.period) {
+    double load = sim_load(&p, t, end);
+
+    // A jump in load starts a new segment; ramps are not step responses
+    if (p.profile != SIM_PROFILE_RAMP && load != last_load) {
+      sim_steps_close(&steps, &p);
+      steps.active = 1;
+      steps.rising = load > last_load;
+      last_load = load;
+    }
+
+    double duty = sim_plant.duty / 65535.0;
+    double airflow = (duty < p.fan_start) ? 0 : duty;
+    double g = p.g_passive + p.g_fan * airflow;
+    double t_inf = p.ambient + load / g;
+    double decay = exp(-h * g / p.capacity);
+
+    for (int i = 0; i < SIM_SUBSTEPS; i++) {
+      sim_plant.temp = t_inf + (sim_plant.temp - t_inf) * decay;
+      sim_plant.sensor += (sim_plant.temp - sim_plant.sensor) * sensor_k;
+    }
+
+    energy += p.fan_power * duty * p.period;
+    if (sim_plant.temp > peak)
+      peak = sim_plant.temp;
+    if (p.profile != SIM_PROFILE_RAMP)
+      sim_steps_add(&steps, sim_plant.temp);
+
+    fan_zone_update(); // The firmware's control pass
+
+    if (sim_plant.duty != last_duty) {
+      changes++;
+      last_duty = sim_plant.duty;
+    }
+  }
+
+  if (p.profile != SIM_PROFILE_RAMP)
+    sim_steps_close(&steps, &p);
+
+  double elapsed = (double)(clock() - started) / CLOCKS_PER_SEC;
+  double mean_over = steps.steps ? steps.overshoot_sum / steps.steps : 0;
+  double mean_settle = steps.steps ? steps.settle_sum / steps.steps : 0;
+
+  if (p.csv) {
+    printf("%.3f,%.3f,%.1f,%.1f,%.3f,%.4f,%lu\n", steps.overshoot_max,
+           mean_over, steps.settle_max, mean_settle, peak, energy / 3600.0,
+           changes);
+  } else {
+    printf("simulated       %.1f h in %.3f s (%.0f h/s)\n", p.hours, elapsed,
+           elapsed > 0 ? p.hours / elapsed : 0);
+    printf("load steps      %u\n", steps.steps);
+    printf("overshoot       max %.2f C, mean %.2f C\n", steps.overshoot_max,
+           mean_over);
+    printf("settling time   max %.0f s, mean %.0f s (+/- %.1f C)\n",
+           steps.settle_max, mean_settle, SIM_SETTLE_BAND);
+    printf("peak temp       %.2f C\n", peak);
+    printf("fan energy      %.3f Wh (duty-weighted, %.1f W at 100%%)\n",
+           energy / 3600.0, p.fan_power);
+    printf("pwm changes     %lu\n", changes);
+    printf("sensor reads    %lu\n", sim_reads);
+  }
+
+  free(steps.trace);
+  return 0;
+}
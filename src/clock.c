@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "clock.h"
+
+#include <avr/io.h>
+#include <avr/power.h>
+#include <util/delay.h>
+
+#if CLOCK_IDLE_SHIFT > 0
+
+#if PWM_BACKEND != PWM_BACKEND_TIMER1 || PWM_CHANNELS > 1
+#error "Timer0 PWM follows the system clock: CLOCK_IDLE_SHIFT needs PWM_BACKEND_TIMER1 with one channel"
+#endif
+
+// The PWM dither ISR and the delay loop must both fit in one PWM period
+#if (F_CPU >> CLOCK_IDLE_SHIFT) / PWM_FREQUENCY < 128
+#error "CLOCK_IDLE_SHIFT too high: less than 128 cycles per PWM period"
+#endif
+
+#endif /* CLOCK_IDLE_SHIFT > 0 */
+
+/**
+ * Divide the system clock by 2^CLOCK_IDLE_SHIFT.
+ *
+ * Only clock_delay_ms() and interrupt handlers that do not depend on F_CPU
+ * (PWM dither, tach, I2C slave) may run until clock_fast().
+ */
+void clock_slow(void) {
+#if CLOCK_IDLE_SHIFT > 0
+  clock_prescale_set((clock_div_t)CLOCK_IDLE_SHIFT);
+#endif
+}
+
+/**
+ * Restore the full F_CPU system clock.
+ */
+void clock_fast(void) {
+#if CLOCK_IDLE_SHIFT > 0
+  clock_prescale_set(clock_div_1);
+#endif
+}
+
+/**
+ * Busy-wait, correct at full and at scaled system clock.
+ *
+ * With clock scaling, time is counted in Timer1 PWM periods: OCR1A is not
+ * used by the PWM and stays 0, so its compare flag is set once per period
+ * from the PLL clock. Unlike _delay_ms(), interrupt handlers do not stretch
+ * the delay.
+ *
+ * @param ms Delay in milliseconds
+ */
+void clock_delay_ms(uint16_t ms) {
+#if CLOCK_IDLE_SHIFT > 0
+  uint32_t periods = (uint32_t)ms * PWM_FREQUENCY / 1000;
+
+  TIFR = (1 << OCF1A); // Drop a stale match, error below one period
+  while (periods--) {
+    while (!(TIFR & (1 << OCF1A)))
+      ;
+    TIFR = (1 << OCF1A);
+  }
+#else
+  while (ms--) {
+    _delay_ms(1);
+  }
+#endif
+}
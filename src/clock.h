@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_CLOCK_H_
+#define TINY85FANCONTROL_SRC_CLOCK_H_
+
+/**
+ * Runtime system clock scaling with CLKPR.
+ *
+ * The controller is idle most of the time, waiting between control passes.
+ * clock_slow() divides the system clock by 2^CLOCK_IDLE_SHIFT for that
+ * wait, and clock_fast() restores F_CPU for the control pass. Everything
+ * timed by _delay_us() / _delay_ms() (1-Wire slots, UART bits) is built for
+ * F_CPU and must only run at full speed.
+ *
+ * Timer1 is clocked from the asynchronous 64 MHz PLL clock, so its PWM
+ * frequency does not change with CLKPR, and clock_delay_ms() counts Timer1
+ * PWM periods to keep time at any setting. Timer0 runs from the system
+ * clock, so scaling needs Timer1 as the only PWM timer: in the default
+ * Timer0 build CLOCK_IDLE_SHIFT is 0 and clock_slow() / clock_fast() do
+ * nothing.
+ */
+
+#include "pwm.h"
+
+#include <stdint.h>
+
+// System clock divider between control passes, as a power of 2
+#ifndef CLOCK_IDLE_SHIFT
+#if PWM_BACKEND == PWM_BACKEND_TIMER1 && PWM_CHANNELS == 1
+#define CLOCK_IDLE_SHIFT (2) // F_CPU / 4, 4 MHz
+#else
+#define CLOCK_IDLE_SHIFT (0) // Timer0 PWM: no scaling
+#endif
+#endif
+
+void clock_slow(void);
+void clock_fast(void);
+void clock_delay_ms(uint16_t ms);
+
+#endif /* TINY85FANCONTROL_SRC_CLOCK_H_ */
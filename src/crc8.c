@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "crc8.h"
+
+#include <avr/pgmspace.h>
+
+// CRC8 of a byte's low and high nibble, split so that 32 bytes of flash
+// replace the 8 shift/xor rounds per byte (Maxim application note 27)
+static const uint8_t crc8_lo[16] PROGMEM = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83,
+    0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41};
+static const uint8_t crc8_hi[16] PROGMEM = {
+    0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8,
+    0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74};
+
+/**
+ * Add one byte to a running Dallas/Maxim OneWire CRC8, e.g. for data that
+ * is not in one buffer. Start from 0.
+ * @param crc   CRC of the bytes so far
+ * @param data  next byte
+ * @return      CRC including data
+ */
+uint8_t crc8_update(uint8_t crc, uint8_t data) {
+  uint8_t in = crc ^ data;
+  return pgm_read_byte(&crc8_lo[in & 0x0F]) ^ pgm_read_byte(&crc8_hi[in >> 4]);
+}
+
+/**
+ * Compute Dallas/Maxim OneWire CRC8 (poly = x^8 + x^5 + x^4 + 1, reflect=1)
+ * @param data  pointer to bytes
+ * @param len   number of bytes
+ * @return      8-bit CRC
+ */
+uint8_t crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    crc = crc8_update(crc, *data++);
+  }
+  return crc;
+}
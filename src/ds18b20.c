@@ -24,65 +24,112 @@
  *
  */
 #include "ds18b20.h"
+#include "crc8.h"
+#include "profile.h"
 #include "onewire.h"
+#include "sensor.h"
 
+#include <stddef.h>
+#include <string.h>
 #include <util/delay.h>
 
-// Error reading temperature, return -273°C in 0.01°C units
-#define DS18B20_ERROR (-(273 << 4))
+#define DS18B20_FAMILY_CODE (0x28)
+#define DS18B20_CMD_CONVERT_T (0x44)
+#define DS18B20_CMD_READ_SCRATCHPAD (0xBE)
+#define DS18B20_CMD_WRITE_SCRATCHPAD (0x4E)
+#define DS18B20_CONFIG_12BIT (0x7F) // Configuration register, R1 = R0 = 1
+
+// Longest conversion, 12-bit resolution (datasheet tCONV = 750 ms)
+#define DS18B20_CONVERSION_TIMEOUT_MS (750)
+
+// ROM codes of the sensors found by ds18b20_scan()
+static uint8_t ds18b20_roms[DS18B20_MAX_SENSORS][ONEWIRE_ROM_SIZE];
+static uint8_t ds18b20_sensor_count = 0;
+
+#if DS18B20_FAST_READ == 1
+#error "DS18B20_FAST_READ 1 would be a full read every time: use 0, or N > 1"
+#endif
+
+#if DS18B20_FAST_READ > 1
+
+// Raw readings the sensor can produce: -55 °C to 125 °C
+#define DS18B20_RAW_MIN (-55 * 16)
+#define DS18B20_RAW_MAX (125 * 16)
+#define DS18B20_RAW_POWER_ON (85 * 16) // Scratchpad value before conversion
+#define DS18B20_RAW_ALL_ONES (-1)      // Bus stuck high: -0.0625 °C
+
+// Last good reading of each sensor, and fast reads left before a full one
+static int16_t ds18b20_last[DS18B20_MAX_SENSORS];
+static uint8_t ds18b20_fast_left[DS18B20_MAX_SENSORS];
+
+#endif /* DS18B20_FAST_READ > 1 */
+
+#if DS18B20_ALARM_MODE
+
+#if DS18B20_MAX_SENSORS > 8
+#error "Alarm mode reports sensors in an 8-bit mask: DS18B20_MAX_SENSORS <= 8"
+#endif
+
+// TL / TH last written to each sensor, both 0 when not programmed
+static int8_t ds18b20_alarm_low[DS18B20_MAX_SENSORS];
+static int8_t ds18b20_alarm_high[DS18B20_MAX_SENSORS];
+static uint8_t ds18b20_alarm_passes = 0;
 
 /**
- * Compute Dallas/Maxim OneWire CRC8 (poly = x^8 + x^5 + x^4 + 1, reflect=1)
- * @param data  pointer to bytes
- * @param len   number of bytes
- * @return      8-bit CRC
+ * Forget the programmed windows, so that the next ds18b20_set_alarm()
+ * writes them again.
  */
-static uint8_t crc8(const uint8_t *data, uint8_t len) {
-  uint8_t crc = 0;
-  while (len--) {
-    uint8_t in = *data++;
-    for (uint8_t i = 0; i < 8; i++) {
-      uint8_t mix = (crc ^ in) & 0x01;
-      crc >>= 1;
-      if (mix) {
-        crc ^= 0x8C; // 0x8C = reversed 0x31 polynomial
-      }
-      in >>= 1;
-    }
+static void ds18b20_alarm_clear(void) {
+  for (uint8_t i = 0; i < DS18B20_MAX_SENSORS; i++) {
+    ds18b20_alarm_low[i] = 0;
+    ds18b20_alarm_high[i] = 0;
   }
-  return crc;
 }
 
-int16_t ds18b20_read_raw(void) {
-  uint8_t scratchpad[9];
+#endif /* DS18B20_ALARM_MODE */
 
-  if (onewire_reset() == ONEWIRE_ERROR) {
-    return DS18B20_ERROR; // Error reading temperature
+/**
+ * Address one sensor (MATCH ROM) or all of them (SKIP ROM) after a reset.
+ * @param rom  8-byte ROM code, or NULL for all devices on the bus
+ */
+static void ds18b20_select(const uint8_t *rom) {
+  if (!rom) {
+    onewire_write_byte(ONEWIRE_CMD_SKIP_ROM); // to all devices on the bus
+    return;
   }
 
-  onewire_write_byte(0xCC); // to all devices on the bus
-  onewire_write_byte(0x44); // send DS18B20 command, "CONVERT T"
+  onewire_write_byte(ONEWIRE_CMD_MATCH_ROM);
+  onewire_write_block(rom, ONEWIRE_ROM_SIZE);
+}
 
-  while (!onewire_read_bus()) {
-    // Wait for the bus to be released
-    _delay_ms(16); // Short delay to avoid busy-waiting
-  }
+/**
+ * Read and CRC-check the scratchpad of one sensor.
+ * @param rom  8-byte ROM code, or NULL when there is a single sensor
+ * @return     raw temperature (1/16 °C), DS18B20_ERROR on failure
+ */
+static int16_t ds18b20_read_scratchpad(const uint8_t *rom) {
+  uint8_t scratchpad[9];
+
+  profile_start(PROFILE_SCRATCHPAD);
 
-  _delay_ms(256); // Wait for conversion to complete
+  if (onewire_reset() != ONEWIRE_LOW) {
+    profile_stop(PROFILE_SCRATCHPAD);
+    return DS18B20_ERROR; // No presence pulse or bus error
+  }
 
-  onewire_reset();          // Reset the bus again
-  onewire_write_byte(0xCC); // to all devices on the bus
-  onewire_write_byte(0xBE); // send DS18B20 command, "READ SCRATCHPAD"
+  ds18b20_select(rom);
+  onewire_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
 
   // Read all 9 bytes of scratchpad
-  for (uint8_t i = 0; i < 9; i++) {
-    scratchpad[i] = onewire_read_byte();
-  }
+  onewire_read_block(scratchpad, sizeof(scratchpad));
 
   onewire_reset(); // Reset the bus again
 
   // Verify CRC
-  if (crc8(scratchpad, 8) != scratchpad[8]) {
+  uint8_t crc = crc8(scratchpad, 8);
+  profile_stop(PROFILE_SCRATCHPAD);
+
+  if (crc != scratchpad[8]) {
     return DS18B20_ERROR; // CRC error, return error value
   }
 
@@ -96,11 +143,260 @@ int16_t ds18b20_read_raw(void) {
   return raw_temp;
 }
 
+#if DS18B20_FAST_READ > 1
+
+/**
+ * Read only the two temperature bytes of the scratchpad, then end the
+ * read with a reset. No CRC: see ds18b20_plausible().
+ * @param rom  8-byte ROM code, or NULL when there is a single sensor
+ * @return     raw temperature (1/16 °C), DS18B20_ERROR on bus failure
+ */
+static int16_t ds18b20_read_temperature(const uint8_t *rom) {
+  profile_start(PROFILE_SCRATCHPAD);
+
+  if (onewire_reset() != ONEWIRE_LOW) {
+    profile_stop(PROFILE_SCRATCHPAD);
+    return DS18B20_ERROR; // No presence pulse or bus error
+  }
+
+  ds18b20_select(rom);
+  onewire_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
+
+  uint8_t lo = onewire_read_byte();
+  uint8_t hi = onewire_read_byte();
+
+  onewire_reset(); // Stop the sensor sending the rest
+  profile_stop(PROFILE_SCRATCHPAD);
+
+  return ((int16_t)(hi << 8)) | lo;
+}
+
+/**
+ * Check an unverified reading against the last good one of the sensor.
+ *
+ * Rejects values outside the sensor's -55..125 °C range (this includes
+ * bad sign extension), the all-ones value of a bus that is stuck high
+ * (it is in range and would pass near 0 °C), the 85 °C power-on value,
+ * and steps larger than DS18B20_FAST_MAX_STEP.
+ *
+ * @return 1 if the reading can be used without a CRC check
+ */
+static uint8_t ds18b20_plausible(int16_t raw, int16_t last) {
+  int16_t step = raw - last;
+
+  return raw >= DS18B20_RAW_MIN && raw <= DS18B20_RAW_MAX &&
+         raw != DS18B20_RAW_POWER_ON && raw != DS18B20_RAW_ALL_ONES &&
+         step <= DS18B20_FAST_MAX_STEP && step >= -DS18B20_FAST_MAX_STEP;
+}
+
+#endif /* DS18B20_FAST_READ > 1 */
+
+/**
+ * Enumerate the DS18B20 sensors on the bus with SEARCH ROM.
+ *
+ * Sensors are numbered in search order, which follows the ROM codes and so
+ * stays the same across resets. At most DS18B20_MAX_SENSORS are kept.
+ *
+ * @return number of sensors found
+ */
+uint8_t ds18b20_scan(void) {
+  onewire_search_t search = {{0}, 0, 0};
+  uint8_t rom[ONEWIRE_ROM_SIZE];
+
+  ds18b20_sensor_count = 0;
+
+  while (ds18b20_sensor_count < DS18B20_MAX_SENSORS &&
+         onewire_search(&search, ONEWIRE_CMD_SEARCH_ROM, rom) ==
+             ONEWIRE_SEARCH_FOUND) {
+    if (rom[0] != DS18B20_FAMILY_CODE || crc8(rom, 7) != rom[7]) {
+      continue; // Other device family, or corrupted ROM code
+    }
+
+    for (uint8_t i = 0; i < ONEWIRE_ROM_SIZE; i++) {
+      ds18b20_roms[ds18b20_sensor_count][i] = rom[i];
+    }
+    ds18b20_sensor_count++;
+  }
+
+#if DS18B20_ALARM_MODE
+  ds18b20_alarm_clear();
+#endif
+
+  return ds18b20_sensor_count;
+}
+
+/**
+ * @return number of sensors found by the last ds18b20_scan()
+ */
+uint8_t ds18b20_count(void) { return ds18b20_sensor_count; }
+
+/**
+ * Start a temperature conversion on all sensors at once.
+ * @return 1 on success, 0 if the bus is stuck
+ */
+uint8_t ds18b20_start_conversion(void) {
+  if (onewire_reset() == ONEWIRE_ERROR) {
+    return 0;
+  }
+
+  ds18b20_select(NULL);
+  onewire_write_byte(DS18B20_CMD_CONVERT_T); // send DS18B20 command, "CONVERT T"
+  return 1;
+}
+
+/**
+ * Wait for the conversion started by ds18b20_start_conversion().
+ *
+ * Externally powered sensors answer read slots with 0 while converting and 1
+ * when done, so the wait ends as soon as the slowest sensor is ready instead
+ * of after a fixed delay. Bounded by DS18B20_CONVERSION_TIMEOUT_MS.
+ */
+void ds18b20_wait_conversion(void) {
+  for (uint16_t ms = 0; ms < DS18B20_CONVERSION_TIMEOUT_MS; ms++) {
+    if (onewire_read_bit()) {
+      break; // All sensors released the bus
+    }
+    _delay_ms(1);
+  }
+}
+
+/**
+ * Read the last converted temperature of one sensor.
+ *
+ * With zero or one sensor enumerated, index 0 addresses the bus with SKIP
+ * ROM, which also works if the scan was never run.
+ *
+ * @param index  sensor number, 0 to ds18b20_count() - 1
+ * @return       raw temperature (1/16 °C), DS18B20_ERROR on failure
+ */
+int16_t ds18b20_read_sensor_raw(uint8_t index) {
+  const uint8_t *rom = NULL;
+
+  if (ds18b20_sensor_count > 1 || index != 0) {
+    if (index >= ds18b20_sensor_count) {
+      return DS18B20_ERROR;
+    }
+    rom = ds18b20_roms[index];
+  }
+
+#if DS18B20_FAST_READ > 1
+  if (ds18b20_fast_left[index]) {
+    int16_t raw = ds18b20_read_temperature(rom);
+    if (ds18b20_plausible(raw, ds18b20_last[index])) {
+      ds18b20_fast_left[index]--;
+      ds18b20_last[index] = raw;
+      return raw;
+    }
+    // Suspicious: confirm with a full, CRC-checked read
+  }
+
+  int16_t raw = ds18b20_read_scratchpad(rom);
+  if (raw != DS18B20_ERROR) {
+    ds18b20_fast_left[index] = DS18B20_FAST_READ - 1;
+    ds18b20_last[index] = raw;
+  } else {
+    ds18b20_fast_left[index] = 0;
+  }
+
+  return raw;
+#else
+  return ds18b20_read_scratchpad(rom);
+#endif
+}
+
+#if DS18B20_ALARM_MODE
+
+/**
+ * Find the sensors that need a read after a conversion: those whose alarm
+ * flag is set, i.e. whose temperature left the TL < T < TH window.
+ *
+ * A sensor answers ALARM SEARCH only if its last conversion crossed TL or
+ * TH, so with steady temperatures the search ends after a reset, one
+ * command byte and two bit slots. Every DS18B20_ALARM_REFRESH passes, and
+ * whenever the sensors cannot be told apart or the bus does not answer,
+ * all sensors are read; a refresh also rewrites the windows, in case a
+ * sensor lost them at a power cycle. A sensor that stops answering never
+ * shows up here while others keep the bus alive, so callers must also
+ * bound how long they keep a reading (see fan_zone_update()).
+ *
+ * @return Bit n set if sensor n must be read
+ */
+uint8_t ds18b20_alarm_search(void) {
+  if (ds18b20_sensor_count == 0 ||
+      ++ds18b20_alarm_passes >= DS18B20_ALARM_REFRESH) {
+    ds18b20_alarm_passes = 0;
+    ds18b20_alarm_clear();
+    return 0xFF;
+  }
+
+  onewire_search_t search = {{0}, 0, 0};
+  uint8_t rom[ONEWIRE_ROM_SIZE];
+  uint8_t alarms = 0;
+  uint8_t result;
+
+  while ((result = onewire_search(&search, ONEWIRE_CMD_ALARM_SEARCH, rom)) ==
+         ONEWIRE_SEARCH_FOUND) {
+    for (uint8_t i = 0; i < ds18b20_sensor_count; i++) {
+      if (!memcmp(rom, ds18b20_roms[i], ONEWIRE_ROM_SIZE)) {
+        alarms |= 1 << i;
+      }
+    }
+  }
+
+  if (result == ONEWIRE_SEARCH_NO_PRESENCE) {
+    return 0xFF; // Let the reads report the failure
+  }
+
+  return alarms;
+}
+
+/**
+ * Set the alarm window of one sensor for the next conversions. Its alarm
+ * flag is set when the whole-degree part of the temperature is <= low or
+ * >= high. Only written to the sensor's scratchpad (not its EEPROM), and
+ * only when it changes.
+ *
+ * @param index  sensor number, 0 to ds18b20_count() - 1
+ * @param low    TL in °C
+ * @param high   TH in °C, above low
+ */
+void ds18b20_set_alarm(uint8_t index, int8_t low, int8_t high) {
+  if (index >= ds18b20_sensor_count ||
+      (low == ds18b20_alarm_low[index] && high == ds18b20_alarm_high[index])) {
+    return;
+  }
+
+  if (onewire_reset() != ONEWIRE_LOW) {
+    return;
+  }
+
+  ds18b20_select(ds18b20_roms[index]);
+  onewire_write_byte(DS18B20_CMD_WRITE_SCRATCHPAD);
+  onewire_write_byte((uint8_t)high);
+  onewire_write_byte((uint8_t)low);
+  onewire_write_byte(DS18B20_CONFIG_12BIT);
+
+  ds18b20_alarm_low[index] = low;
+  ds18b20_alarm_high[index] = high;
+}
+
+#endif /* DS18B20_ALARM_MODE */
+
+int16_t ds18b20_read_raw(void) {
+  if (!ds18b20_start_conversion()) {
+    return DS18B20_ERROR; // Error reading temperature
+  }
+
+  ds18b20_wait_conversion();
+
+  return ds18b20_read_sensor_raw(0);
+}
+
 int16_t ds18b20_read_celsius(void) {
   int16_t t = ds18b20_read_raw();
 
   // Convert to Celsius: each bit = 0.0625 °C
   // Return temperature in 1 °C units
 
-  return (t + 0x0F) >> 4;
+  return sensor_raw_to_celsius(t);
 }
@@ -28,7 +28,48 @@
 
 #include <stdint.h>
 
+// Error reading temperature, return -273°C in 1/16 °C units
+#define DS18B20_ERROR (-(273 << 4))
+
+// Number of sensors remembered by ds18b20_scan() (8 bytes of RAM each)
+#ifndef DS18B20_MAX_SENSORS
+#define DS18B20_MAX_SENSORS (4)
+#endif
+
+// Fast reads: only the two temperature bytes of the scratchpad, checked
+// for plausibility instead of CRC, with a full CRC-checked read every
+// DS18B20_FAST_READ reads of a sensor and whenever a value looks wrong.
+// 0 reads the full scratchpad every time; 1 is rejected at build time.
+#ifndef DS18B20_FAST_READ
+#define DS18B20_FAST_READ (0)
+#endif
+
+// Largest change between two fast reads of a sensor (1/16 °C, 2 °C)
+#ifndef DS18B20_FAST_MAX_STEP
+#define DS18B20_FAST_MAX_STEP (32)
+#endif
+
+// Alarm-driven sampling: after each conversion, an ALARM SEARCH finds the
+// sensors that left their TH/TL window and only those are read
+#ifndef DS18B20_ALARM_MODE
+#define DS18B20_ALARM_MODE 0
+#endif
+
+// Conversions between full reads of every sensor in alarm mode
+#ifndef DS18B20_ALARM_REFRESH
+#define DS18B20_ALARM_REFRESH (16)
+#endif
+
+uint8_t ds18b20_scan(void);
+uint8_t ds18b20_count(void);
+uint8_t ds18b20_start_conversion(void);
+void ds18b20_wait_conversion(void);
+int16_t ds18b20_read_sensor_raw(uint8_t index);
 int16_t ds18b20_read_raw(void);
 int16_t ds18b20_read_celsius(void);
+#if DS18B20_ALARM_MODE
+uint8_t ds18b20_alarm_search(void);
+void ds18b20_set_alarm(uint8_t index, int8_t low, int8_t high);
+#endif
 
 #endif // TINY85FANCONTROL_DS18B20_H_
\ No newline at end of file
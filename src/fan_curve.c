@@ -26,14 +26,13 @@
 
 #include "fan_curve.h"
 
-// Structure to define a point on the fan curve
-typedef struct {
-  int8_t temperature; // Temperature in Celsius (-85 to +125 C))
-  uint8_t pwm_duty;   // PWM duty cycle (0-255)
-} fan_curve_point_t;
-
 // Define your fan curve points in a PROGMEM array to save RAM
 // The points MUST be sorted by temperature in ascending order.
+// FAN_CURVE_POINTS replaces them from the build, e.g. for simulator sweeps:
+//   -DFAN_CURVE_POINTS="{25,0},{30,128},{45,255}"
+#ifdef FAN_CURVE_POINTS
+static const fan_curve_point_t fan_curve[] = {FAN_CURVE_POINTS};
+#else
 static const fan_curve_point_t fan_curve[] = {
     {25, 0},   // Example: Below 25C, fan is off
     {27, 128},  // At 27C, fan is quiet 50% duty cycle
@@ -43,55 +42,102 @@ static const fan_curve_point_t fan_curve[] = {
     {50, 230}, // At 50C and above, fan is at near full speed
     {60, 255}  // Ensure full speed is maintained even at higher temps
 };
+#endif
 
 #define NUM_FAN_CURVE_POINTS (sizeof(fan_curve) / sizeof(fan_curve_point_t))
 
+const fan_curve_t fan_curve_default = {fan_curve, NUM_FAN_CURVE_POINTS};
+
 /**
- * Compute the PWM duty cycle based on the current temperature.
+ * Compute a 16-bit PWM duty cycle from a fixed-point temperature.
+ *
+ * Linear interpolation between the curve points, at the DS18B20's native
+ * 1/16 °C resolution and returned as 0–65535 so that pwm_set16() can move
+ * the fan in steps much finer than one 8-bit step.
  *
- * @param temperature The current temperature in Celsius.
- * @return The computed PWM duty cycle (0-255).
+ * @param curve The fan curve to evaluate.
+ * @param temp_q4 The current temperature in 1/16 °C (DS18B20 raw format).
+ * @return The computed PWM duty cycle (0-65535).
  */
-uint8_t fan_curve_compute_pwm(int16_t current_temp) {
-  // If current_temp is below the first point, return 0 duty
-  if (current_temp < fan_curve[0].temperature) {
-    return fan_curve[0].pwm_duty;
+uint16_t fan_curve_compute_pwm16(const fan_curve_t *curve, int16_t temp_q4) {
+  const fan_curve_point_t *points = curve->points;
+
+  // Curve duty 0-255 maps onto 0-65535 (x * 257 = x << 8 | x)
+  if (temp_q4 < (points[0].temperature * 16)) {
+    return points[0].pwm_duty * 257U;
   }
 
-  // Find the two points between which to interpolate
-  for (uint8_t i = 0; i < NUM_FAN_CURVE_POINTS - 1; i++) {
-    const fan_curve_point_t *p1 = &fan_curve[i];
-    const fan_curve_point_t *p2 = &fan_curve[i + 1];
-
-    if (current_temp >= p1->temperature && current_temp < p2->temperature) {
-      // Perform linear interpolation (LERP)
-      // current_pwm = p1.pwm_duty + (current_temp - p1.temperature) *
-      // (p2.pwm_duty - p1.pwm_duty) / (p2.temperature - p1.temperature)
-
-      // Use long for calculations to prevent overflow
-      int32_t temp_range = p2->temperature - p1->temperature;
-      int32_t pwm_range = p2->pwm_duty - p1->pwm_duty;
-      int32_t temp_offset = current_temp - p1->temperature;
-
-      // Avoid division by zero if two points have the same temperature
-      if (temp_range == 0) {
-        // (shouldn't happen if sorted uniquely)
-        return p1->pwm_duty;
-      }
-
-      int32_t interpolated_pwm =
-          (int32_t)p1->pwm_duty + (temp_offset * pwm_range) / temp_range;
-
-      // Clamp the result to 0-255 just in case
-      if (interpolated_pwm > 255)
-        return 255;
+  for (uint8_t i = 0; i < curve->count - 1; i++) {
+    const fan_curve_point_t *p1 = &points[i];
+    const fan_curve_point_t *p2 = &points[i + 1];
+    int16_t t1 = p1->temperature * 16;
+    int16_t t2 = p2->temperature * 16;
+
+    if (temp_q4 >= t1 && temp_q4 < t2) {
+      int32_t temp_range = t2 - t1;
+      int32_t pwm_range = (int32_t)(p2->pwm_duty - p1->pwm_duty) * 257;
+      int32_t temp_offset = temp_q4 - t1;
+
+      int32_t interpolated_pwm = (int32_t)p1->pwm_duty * 257 +
+                                 (temp_offset * pwm_range) / temp_range;
+
+      // Clamp the result to 0-65535 just in case
+      if (interpolated_pwm > 0xFFFF)
+        return 0xFFFF;
       if (interpolated_pwm < 0)
         return 0;
 
-      return (uint8_t)interpolated_pwm;
+      return (uint16_t)interpolated_pwm;
     }
   }
 
-  // Handle temperatures equal to or above the last point
-  return fan_curve[NUM_FAN_CURVE_POINTS - 1].pwm_duty;
-}
\ No newline at end of file
+  return points[curve->count - 1].pwm_duty * 257U;
+}
+
+/**
+ * @return The exclusive lower bound of a segment starting at `temp` °C
+ */
+static int8_t fan_curve_below(int8_t temp) {
+  return temp == INT8_MIN ? INT8_MIN : (int8_t)(temp - 1);
+}
+
+/**
+ * Find the segment of a curve that contains a whole-degree temperature.
+ *
+ * The bounds are exclusive, as the DS18B20 alarm thresholds: the segment is
+ * low < temp < high. Below the first and above the last point the curve is
+ * flat and the segment is open-ended (-128 / 127; these two bounds are
+ * inclusive, as int8_t cannot go further).
+ *
+ * @param curve The fan curve.
+ * @param temp Temperature in whole °C.
+ * @param low Receives the lower bound (°C, exclusive).
+ * @param high Receives the upper bound (°C, exclusive).
+ * @return 1 if the duty is the same over the whole segment, 0 if it slopes.
+ */
+uint8_t fan_curve_segment(const fan_curve_t *curve, int8_t temp, int8_t *low,
+                          int8_t *high) {
+  const fan_curve_point_t *points = curve->points;
+  uint8_t last = curve->count - 1;
+
+  if (temp < points[0].temperature) {
+    *low = -128;
+    *high = points[0].temperature;
+    return 1;
+  }
+
+  if (temp >= points[last].temperature) {
+    *low = fan_curve_below(points[last].temperature);
+    *high = 127;
+    return 1;
+  }
+
+  uint8_t i = 0;
+  while (temp >= points[i + 1].temperature) {
+    i++;
+  }
+
+  *low = fan_curve_below(points[i].temperature);
+  *high = points[i + 1].temperature;
+  return points[i].pwm_duty == points[i + 1].pwm_duty;
+}
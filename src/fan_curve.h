@@ -28,6 +28,22 @@
 
 #include <stdint.h>
 
-uint8_t fan_curve_compute_pwm(int16_t temperature);
+// Structure to define a point on the fan curve
+typedef struct {
+  int8_t temperature; // Temperature in Celsius (-85 to +125 C))
+  uint8_t pwm_duty;   // PWM duty cycle (0-255)
+} fan_curve_point_t;
+
+// A fan curve: points sorted by temperature in ascending order
+typedef struct {
+  const fan_curve_point_t *points;
+  uint8_t count;
+} fan_curve_t;
+
+extern const fan_curve_t fan_curve_default;
+
+uint16_t fan_curve_compute_pwm16(const fan_curve_t *curve, int16_t temp_q4);
+uint8_t fan_curve_segment(const fan_curve_t *curve, int8_t temp, int8_t *low,
+                          int8_t *high);
 
 #endif /* TINY85FANCONTROL_SRC_FAN_CURVE_H_ */
\ No newline at end of file
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "fan_zone.h"
+#include "fan_curve.h"
+#include "profile.h"
+#include "sensor.h"
+#include "temp_sensor.h"
+
+// Structure to define the inputs and output of a zone
+typedef struct {
+  uint8_t source;           // FAN_ZONE_SRC_*
+  uint8_t sensor_mask;      // External sensors to take the maximum of
+  uint8_t channel;          // PWM channel driven by this zone
+  const fan_curve_t *curve; // Fan curve of this zone
+  uint16_t ff_gain;         // Feed-forward duty per 1/16 °C/sample rise
+} fan_zone_config_t;
+
+// Control state of a zone
+typedef struct {
+  int16_t temp;  // Filtered temperature in 1/16 °C
+  uint16_t duty; // Last PWM duty cycle (0-65535)
+  uint16_t ff;   // Feed-forward duty added on top of the curve
+  int16_t history[FAN_ZONE_HISTORY]; // Last filtered temperatures (ring)
+  uint8_t history_idx;               // Oldest entry in history
+  uint8_t valid;  // Filter has seen a good sample
+  uint8_t errors; // Consecutive failed samples, up to FAN_ZONE_MAX_ERRORS
+} fan_zone_state_t;
+
+// Define your zones here, one per PWM channel.
+static const fan_zone_config_t fan_zones[FAN_ZONE_COUNT] = {
+    // Zone 0: hottest of all external sensors
+    // +1 °C per sample adds 16 * 512 = 8192 (12.5%) duty
+    {FAN_ZONE_SRC_EXTERNAL, 0xFF, 0, &fan_curve_default, FAN_ZONE_FF_GAIN},
+#if FAN_ZONE_COUNT > 1
+    // Zone 1: second external sensor only, no feed-forward
+    {FAN_ZONE_SRC_EXTERNAL, 0x02, 1, &fan_curve_default, 0},
+#endif
+};
+
+static fan_zone_state_t fan_zone_state[FAN_ZONE_COUNT];
+
+// Duty forced on all zones by fan_zone_override(), if active
+static uint8_t fan_zone_forced = 0;
+static uint16_t fan_zone_forced_duty = 0;
+
+#if SENSOR_ALARMS
+// Last reading of each external sensor, kept while it stays in its window
+static int16_t fan_zone_readings[SENSOR_MAX_SENSORS];
+// Passes each reading has been reused, up to FAN_ZONE_ALARM_MAX_AGE
+static uint8_t fan_zone_reading_age[SENSOR_MAX_SENSORS];
+#endif
+
+// Conversion started by fan_zone_start(): 0 = none, 1 = running, 2 = bus error
+static uint8_t fan_zone_conversion = 0;
+
+/**
+ * Enumerate the external sensors used by the zones.
+ */
+void fan_zone_init(void) {
+  sensor_scan();
+
+#if SENSOR_ALARMS
+  for (uint8_t i = 0; i < SENSOR_MAX_SENSORS; i++) {
+    fan_zone_readings[i] = SENSOR_ERROR; // Nothing to keep yet: read
+  }
+#endif
+}
+
+/**
+ * External sensors feeding a zone. A zone whose sensors are not on the bus
+ * (e.g. zone 1 on a board with one DS18B20) takes zone 0's sensors.
+ *
+ * @param cfg Zone configuration
+ * @param count Number of sensors found
+ * @return Sensor mask, bit n = sensor n
+ */
+static uint8_t fan_zone_mask(const fan_zone_config_t *cfg, uint8_t count) {
+  uint8_t mask = cfg->sensor_mask & (uint8_t)((1 << count) - 1);
+  return mask ? mask : fan_zones[0].sensor_mask;
+}
+
+/**
+ * Read the temperature source of a zone.
+ *
+ * @param cfg Zone configuration
+ * @param temps Sensor readings of this pass, 1/16 °C
+ * @param count Number of entries in temps
+ * @return Temperature in 1/16 °C, SENSOR_ERROR if no source is readable
+ */
+static int16_t fan_zone_sample(const fan_zone_config_t *cfg,
+                               const int16_t *temps, uint8_t count) {
+  if (cfg->source == FAN_ZONE_SRC_INTERNAL) {
+    return temp_sensor_read_celsius() * 16;
+  }
+
+  uint8_t mask = fan_zone_mask(cfg, count);
+  int16_t hottest = SENSOR_ERROR; // Failed sensors read as -273 °C
+  for (uint8_t i = 0; i < count; i++) {
+    if ((mask & (1 << i)) && temps[i] > hottest) {
+      hottest = temps[i];
+    }
+  }
+
+  return hottest;
+}
+
+/**
+ * Update the feed-forward term of a zone from the rate of change of its
+ * filtered temperature.
+ *
+ * The rate is the difference to the sample FAN_ZONE_HISTORY passes ago, in
+ * fixed point (1/16 °C per FAN_ZONE_HISTORY samples). While the temperature
+ * rises, feed-forward follows ff_gain * rate; once it levels off or falls,
+ * feed-forward decays by half every pass, so the curve takes over again.
+ *
+ * @param cfg Zone configuration
+ * @param st Zone state, with st->temp already updated
+ * @return Feed-forward duty (0-65535)
+ */
+static uint16_t fan_zone_feed_forward(const fan_zone_config_t *cfg,
+                                      fan_zone_state_t *st) {
+  int16_t delta = st->temp - st->history[st->history_idx];
+
+  st->history[st->history_idx] = st->temp;
+  st->history_idx = (st->history_idx + 1) % FAN_ZONE_HISTORY;
+
+  int32_t target = 0;
+  if (delta > 0) {
+    target = ((int32_t)cfg->ff_gain * delta) / FAN_ZONE_HISTORY;
+    if (target > 0xFFFF)
+      target = 0xFFFF;
+  }
+
+  uint16_t decayed = st->ff - ((st->ff + 1) >> 1);
+  st->ff = ((uint16_t)target > decayed) ? (uint16_t)target : decayed;
+
+  return st->ff;
+}
+
+#if SENSOR_ALARMS
+/**
+ * Program the alarm window of every external sensor for the next
+ * conversion: the intersection of the windows of all zones it feeds.
+ *
+ * A zone's window is the sensor's whole-degree temperature
+ * ± (FAN_ZONE_ALARM_BAND + 1) °C, clipped to the curve segment it is in.
+ * On a flat segment (e.g. fan off below the first point) a zone without
+ * feed-forward takes the whole segment, since the duty cannot change in it.
+ *
+ * @param temps Sensor readings of this pass, 1/16 °C
+ * @param count Number of entries in temps
+ */
+static void fan_zone_set_alarms(const int16_t *temps, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (temps[i] == SENSOR_ERROR) {
+      continue; // Read again next pass anyway
+    }
+
+    int8_t temp = (int8_t)(temps[i] >> 4); // Whole °C, as TH / TL compare
+    int8_t low = -128;
+    int8_t high = 127;
+
+    for (uint8_t z = 0; z < FAN_ZONE_COUNT; z++) {
+      const fan_zone_config_t *cfg = &fan_zones[z];
+      if (cfg->source != FAN_ZONE_SRC_EXTERNAL ||
+          !(fan_zone_mask(cfg, count) & (1 << i))) {
+        continue;
+      }
+
+      int8_t seg_low, seg_high;
+      uint8_t flat = fan_curve_segment(cfg->curve, temp, &seg_low, &seg_high);
+
+      if (!flat || cfg->ff_gain) {
+        int16_t band_low = temp - 1 - FAN_ZONE_ALARM_BAND;
+        int16_t band_high = temp + 1 + FAN_ZONE_ALARM_BAND;
+        if (band_low > seg_low)
+          seg_low = (int8_t)band_low;
+        if (band_high < seg_high)
+          seg_high = (int8_t)band_high;
+      }
+
+      if (seg_low > low)
+        low = seg_low;
+      if (seg_high < high)
+        high = seg_high;
+    }
+
+    sensor_set_alarm(i, low, high);
+  }
+}
+#endif /* SENSOR_ALARMS */
+
+/**
+ * Start the sensor conversion for the next fan_zone_update() early, so that
+ * it runs while the caller does something else (e.g. fan spin-up).
+ */
+void fan_zone_start(void) {
+  fan_zone_conversion = sensor_start_conversion() ? 1 : 2;
+}
+
+/**
+ * Run one control pass: convert all external sensors at once (unless
+ * fan_zone_start() already did), read each of them once, then filter,
+ * evaluate the curve and set the PWM of every zone.
+ *
+ * @return Number of sensor reads that failed in this pass
+ */
+uint8_t fan_zone_update(void) {
+  uint8_t errors = 0;
+  int16_t temps[SENSOR_MAX_SENSORS];
+  uint8_t count = sensor_count();
+
+  if (count == 0) {
+    count = 1; // None found: DS18B20 still tries a single sensor (SKIP ROM)
+  }
+
+  if (!fan_zone_conversion) {
+    fan_zone_start();
+  }
+
+  uint8_t converted = (fan_zone_conversion == 1);
+  if (converted) {
+    sensor_wait_conversion(); // Returns at once if already finished
+  }
+  fan_zone_conversion = 0;
+
+#if SENSOR_ALARMS
+  uint8_t alarms = converted ? sensor_alarms() : 0;
+#endif
+
+  for (uint8_t i = 0; i < count; i++) {
+#if SENSOR_ALARMS
+    if (converted && !(alarms & (1 << i)) &&
+        fan_zone_readings[i] != SENSOR_ERROR &&
+        ++fan_zone_reading_age[i] < FAN_ZONE_ALARM_MAX_AGE) {
+      temps[i] = fan_zone_readings[i]; // Still inside its alarm window
+      continue;
+    }
+    fan_zone_reading_age[i] = 0;
+#endif
+    temps[i] = converted ? sensor_read_raw(i) : SENSOR_ERROR;
+    if (temps[i] == SENSOR_ERROR) {
+      errors++;
+    }
+#if SENSOR_ALARMS
+    fan_zone_readings[i] = temps[i];
+#endif
+  }
+
+  for (uint8_t z = 0; z < FAN_ZONE_COUNT; z++) {
+    const fan_zone_config_t *cfg = &fan_zones[z];
+    fan_zone_state_t *st = &fan_zone_state[z];
+    int16_t sample = fan_zone_sample(cfg, temps, count);
+
+    if (sample == SENSOR_ERROR) {
+      if (st->errors < FAN_ZONE_MAX_ERRORS)
+        st->errors++;
+    } else {
+      st->errors = 0;
+    }
+
+    if (sample != SENSOR_ERROR && st->valid) {
+      // Exponential moving average, rounded to nearest
+      st->temp += (sample - st->temp + (1 << (FAN_ZONE_FILTER_SHIFT - 1))) >>
+                  FAN_ZONE_FILTER_SHIFT;
+    } else if (!st->valid) {
+      st->temp = sample; // First sample (or error) seeds the filter
+      st->valid = (sample != SENSOR_ERROR);
+      for (uint8_t i = 0; i < FAN_ZONE_HISTORY; i++) {
+        st->history[i] = st->temp; // No rate of change yet
+      }
+    }
+    // A failed read after a good one holds the last filtered value, for up
+    // to FAN_ZONE_MAX_ERRORS passes
+
+    // No good sample yet, or none for too long: full speed, not -273 °C
+    uint32_t duty = 0xFFFF;
+    if (st->valid && st->errors < FAN_ZONE_MAX_ERRORS) {
+      profile_start(PROFILE_CURVE);
+      duty = fan_curve_compute_pwm16(cfg->curve, st->temp);
+      profile_stop(PROFILE_CURVE);
+      duty += fan_zone_feed_forward(cfg, st);
+    }
+    st->duty = (duty > 0xFFFF) ? 0xFFFF : (uint16_t)duty;
+    if (fan_zone_forced) {
+      st->duty = fan_zone_forced_duty; // Filter and feed-forward keep tracking
+    }
+    pwm_channel_set16(cfg->channel, st->duty);
+  }
+
+#if SENSOR_ALARMS
+  fan_zone_set_alarms(temps, count);
+#endif
+
+  return errors;
+}
+
+/**
+ * @param zone Zone number, 0 to FAN_ZONE_COUNT - 1
+ * @return Filtered temperature of the zone in 1/16 °C
+ */
+int16_t fan_zone_temp(uint8_t zone) { return fan_zone_state[zone].temp; }
+
+/**
+ * @param zone Zone number, 0 to FAN_ZONE_COUNT - 1
+ * @return Current PWM duty cycle of the zone (0-65535)
+ */
+uint16_t fan_zone_duty(uint8_t zone) { return fan_zone_state[zone].duty; }
+
+/**
+ * Force the duty cycle of all zones from the next fan_zone_update() on,
+ * e.g. on request of a host. The curves take over again when released.
+ *
+ * @param active Non-zero to force, 0 to return to the fan curves
+ * @param duty PWM duty cycle to force (0-65535)
+ */
+void fan_zone_override(uint8_t active, uint16_t duty) {
+  fan_zone_forced = active;
+  fan_zone_forced_duty = duty;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_FAN_ZONE_H_
+#define TINY85FANCONTROL_SRC_FAN_ZONE_H_
+
+/**
+ * Fan zones: one per PWM channel, each with its own curve, temperature
+ * source and filter state. fan_zone_update() runs one control pass for all
+ * zones, sharing a single sensor conversion between them.
+ *
+ * Temperature sources:
+ *  • FAN_ZONE_SRC_EXTERNAL: hottest of the external sensors in sensor_mask
+ *                           (bit n = sensor n in sensor_scan() order)
+ *  • FAN_ZONE_SRC_INTERNAL: ATtiny85 internal temperature sensor
+ *
+ * On top of the static curve, each zone can add a feed-forward duty that is
+ * proportional to how fast its temperature is rising (ff_gain), so fans
+ * speed up before the heat arrives and settle back once it levels off.
+ */
+
+#include "pwm.h"
+
+#include <stdint.h>
+
+#define FAN_ZONE_COUNT PWM_CHANNELS
+
+// Temperature filter: filtered += (sample - filtered) / 2^FAN_ZONE_FILTER_SHIFT
+#ifndef FAN_ZONE_FILTER_SHIFT
+#define FAN_ZONE_FILTER_SHIFT (2) // 1 or more
+#endif
+
+// Samples of temperature history for the feed-forward rate of change
+#ifndef FAN_ZONE_HISTORY
+#define FAN_ZONE_HISTORY (4)
+#endif
+
+// Feed-forward gain of zone 0, duty per 1/16 °C/sample rise (0 = off)
+#ifndef FAN_ZONE_FF_GAIN
+#define FAN_ZONE_FF_GAIN (512)
+#endif
+
+// Consecutive failed samples after which a zone runs at full duty, until a
+// good sample returns (~8 s)
+#ifndef FAN_ZONE_MAX_ERRORS
+#define FAN_ZONE_MAX_ERRORS (3)
+#endif
+
+// Alarm-driven sampling (SENSOR_ALARMS): a sensor is read again once its
+// whole-degree temperature moves by more than this many °C, or leaves a
+// flat part of the curve of a zone without feed-forward
+#ifndef FAN_ZONE_ALARM_BAND
+#define FAN_ZONE_ALARM_BAND (0)
+#endif
+
+// Alarm-driven sampling: passes a reading is reused without an alarm before
+// the sensor is read anyway (~11 s), so one that stopped answering is caught
+#ifndef FAN_ZONE_ALARM_MAX_AGE
+#define FAN_ZONE_ALARM_MAX_AGE (4)
+#endif
+
+enum {
+  FAN_ZONE_SRC_EXTERNAL = 0,
+  FAN_ZONE_SRC_INTERNAL = 1,
+};
+
+void fan_zone_init(void);
+void fan_zone_start(void);
+uint8_t fan_zone_update(void);
+int16_t fan_zone_temp(uint8_t zone);
+uint16_t fan_zone_duty(uint8_t zone);
+void fan_zone_override(uint8_t active, uint16_t duty);
+
+#endif /* TINY85FANCONTROL_SRC_FAN_ZONE_H_ */
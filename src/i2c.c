@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "i2c.h"
+#include "pwm.h"
+#include "uart.h"
+
+#include <avr/io.h>
+#include <util/delay.h>
+
+#if PWM_BACKEND != PWM_BACKEND_TIMER1 || PWM_CHANNELS > 1
+#error "USI SDA is PB0 (OC0A): use PWM_BACKEND_TIMER1 with one channel"
+#endif
+
+#if UART_ENABLE && (UART_TX_PIN == I2C_SCL || UART_TX_PIN == I2C_SDA)
+#error "USI uses PB0 and PB2: move UART_TX_PIN (e.g. to PB1)"
+#endif
+
+// Bus timing (us): SCL low period, SCL high period
+#ifdef I2C_STANDARD_MODE
+#define I2C_T_LOW (4.7)
+#define I2C_T_HIGH (4.0)
+#else
+#define I2C_T_LOW (1.3)
+#define I2C_T_HIGH (0.6)
+#endif
+
+// USISR values: clear all flags, count 16 edges (8 bits) or 2 edges (1 bit)
+#define I2C_USISR_8BIT                                                         \
+  ((1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC))
+#define I2C_USISR_1BIT                                                         \
+  ((1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0x0E))
+
+// Set when SCL stayed low or the USI counter did not overflow, cleared by
+// i2c_start(); transfers are skipped while it is set
+static uint8_t i2c_timeout = 0;
+
+/**
+ * Wait for SCL to go high after releasing it (clock stretching).
+ *
+ * @return 1 once SCL is high, 0 (and i2c_timeout set) if it is still low
+ *         after I2C_RETRY_COUNT tries
+ */
+static uint8_t i2c_wait_scl(void) {
+  uint8_t retry_count = I2C_RETRY_COUNT;
+
+  while (!(I2C_PIN & (1 << I2C_SCL))) {
+    if (retry_count == 0) {
+      // Error: SCL stuck low (no pull-up, short, or endless stretching)
+      i2c_timeout = 1;
+      return 0;
+    }
+
+    _delay_us(4);
+    --retry_count;
+  }
+
+  return 1;
+}
+
+/**
+ * Clock bits through the USI until its counter overflows.
+ *
+ * @param usisr Status register value, selecting the number of bits
+ * @return The data register after the transfer, 0xFF (a NACK) on timeout
+ */
+static uint8_t i2c_transfer(uint8_t usisr) {
+  uint8_t clocks = 8; // SCL pulses for a byte; the counter overflows first
+
+  if (i2c_timeout) {
+    return 0xFF;
+  }
+
+  USISR = usisr;
+
+  do {
+    _delay_us(I2C_T_LOW);
+    USICR |= (1 << USITC); // SCL high
+    if (!i2c_wait_scl()) {
+      break;
+    }
+    _delay_us(I2C_T_HIGH);
+    USICR |= (1 << USITC); // SCL low
+    if (clocks-- == 0) {
+      i2c_timeout = 1; // Counter never overflowed
+      break;
+    }
+  } while (!(USISR & (1 << USIOIF)));
+
+  if (i2c_timeout) {
+    USIDR = 0xFF;              // Release SDA
+    I2C_DDR |= (1 << I2C_SDA); // SDA back to output (driven by USIDR)
+    return 0xFF;
+  }
+
+  _delay_us(I2C_T_LOW);
+  uint8_t data = USIDR;
+  USIDR = 0xFF;                 // Release SDA
+  I2C_DDR |= (1 << I2C_SDA);    // SDA back to output (driven by USIDR)
+
+  return data;
+}
+
+/**
+ * Set up the USI in two-wire mode with both lines released.
+ */
+void i2c_init(void) {
+  I2C_PORT |= (1 << I2C_SDA) | (1 << I2C_SCL); // Release lines
+  I2C_DDR |= (1 << I2C_SDA) | (1 << I2C_SCL);  // Outputs, open drain by USI
+
+  USIDR = 0xFF;
+  USICR = (1 << USIWM1)                    // Two-wire mode
+          | (1 << USICS1) | (1 << USICLK); // Software clock strobe (USITC)
+  USISR = I2C_USISR_8BIT;
+}
+
+/**
+ * Send a (repeated) start condition and the address byte.
+ *
+ * @param address 7-bit address shifted left, ORed with I2C_READ / I2C_WRITE
+ * @return 1 if the device acknowledged, 0 otherwise
+ */
+uint8_t i2c_start(uint8_t address) {
+  i2c_timeout = 0;
+  I2C_PORT |= (1 << I2C_SCL); // Release SCL
+  if (!i2c_wait_scl()) {
+    return 0;
+  }
+  _delay_us(I2C_T_LOW);
+
+  I2C_PORT &= ~(1 << I2C_SDA); // SDA low while SCL high: start
+  _delay_us(I2C_T_HIGH);
+  I2C_PORT &= ~(1 << I2C_SCL); // Pull SCL low
+  I2C_PORT |= (1 << I2C_SDA);  // Release SDA, USIDR drives it from now on
+
+  return i2c_write(address);
+}
+
+/**
+ * Send a stop condition.
+ */
+void i2c_stop(void) {
+  I2C_PORT &= ~(1 << I2C_SDA); // SDA low
+  I2C_PORT |= (1 << I2C_SCL);  // Release SCL
+  if (!i2c_wait_scl()) {
+    I2C_PORT |= (1 << I2C_SDA); // Release SDA anyway
+    return;
+  }
+  _delay_us(I2C_T_HIGH);
+  I2C_PORT |= (1 << I2C_SDA); // SDA high while SCL high: stop
+  _delay_us(I2C_T_LOW);
+}
+
+/**
+ * Write one byte and read the acknowledge bit.
+ *
+ * @param data Byte to send
+ * @return 1 if the device acknowledged, 0 otherwise
+ */
+uint8_t i2c_write(uint8_t data) {
+  I2C_PORT &= ~(1 << I2C_SCL);
+  USIDR = data;
+  i2c_transfer(I2C_USISR_8BIT);
+
+  I2C_DDR &= ~(1 << I2C_SDA); // SDA input for the acknowledge
+  return !(i2c_transfer(I2C_USISR_1BIT) & 0x01);
+}
+
+/**
+ * Read one byte.
+ *
+ * @param ack 1 to acknowledge (more bytes follow), 0 for the last byte
+ * @return The byte read
+ */
+uint8_t i2c_read(uint8_t ack) {
+  I2C_DDR &= ~(1 << I2C_SDA); // SDA input for the data
+  uint8_t data = i2c_transfer(I2C_USISR_8BIT);
+
+  USIDR = ack ? 0x00 : 0xFF; // Drive the acknowledge bit
+  i2c_transfer(I2C_USISR_1BIT);
+
+  return data;
+}
+
+/**
+ * @return 1 if SCL was held low too long (or the USI stalled) since the last
+ *         i2c_start(), so the bytes read since then are not valid
+ */
+uint8_t i2c_error(void) { return i2c_timeout; }
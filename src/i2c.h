@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_I2C_H_
+#define TINY85FANCONTROL_SRC_I2C_H_
+
+/**
+ * I2C (TWI) master on the ATtiny85 USI, after Atmel application note AVR310.
+ *
+ * The USI shifts the bits and counts the clock edges; SCL is strobed in
+ * software with the bus timing below. The USI pins are fixed: SDA on PB0
+ * and SCL on PB2, so PWM must use Timer1 (PB4) and UART TX must move off PB2.
+ *
+ * Fast mode (400 kHz) by default; define I2C_STANDARD_MODE for 100 kHz.
+ *
+ * Every wait is bounded: if SCL stays low (missing pull-up, short, a slave
+ * stretching forever) the transaction fails as a NACK and i2c_error() is
+ * set until the next i2c_start().
+ */
+
+#include <stdint.h>
+
+#define I2C_DDR DDRB
+#define I2C_PORT PORTB
+#define I2C_PIN PINB
+#define I2C_SDA PB0
+#define I2C_SCL PB2
+
+// Tries, 4 us apart, for SCL to go high: ~1 ms clock-stretching limit
+#ifndef I2C_RETRY_COUNT
+#define I2C_RETRY_COUNT (250)
+#endif
+
+#define I2C_READ (1)  // R/W bit of the address byte
+#define I2C_WRITE (0)
+
+void i2c_init(void);
+uint8_t i2c_start(uint8_t address);
+void i2c_stop(void);
+uint8_t i2c_write(uint8_t data);
+uint8_t i2c_read(uint8_t ack);
+uint8_t i2c_error(void);
+
+#endif /* TINY85FANCONTROL_SRC_I2C_H_ */
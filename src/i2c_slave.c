@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "i2c_slave.h"
+#include "fan_curve.h"
+#include "i2c.h"
+#include "pwm.h"
+#include "sensor.h"
+#include "uart.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#if PWM_BACKEND != PWM_BACKEND_TIMER1 || PWM_CHANNELS > 1
+#error "USI SDA is PB0 (OC0A): use PWM_BACKEND_TIMER1 with one channel"
+#endif
+
+#if UART_ENABLE
+#error "No pin left for UART TX with the I2C slave: set UART_ENABLE to 0"
+#endif
+
+#if SENSOR != SENSOR_DS18B20
+#error "The USI cannot be I2C master and slave: use SENSOR_DS18B20"
+#endif
+
+// Dynamic registers 0x00-0x07, published by the main loop
+#define I2C_SLAVE_SNAPSHOT_SIZE (8)
+
+// Transfer states, entered on each USI counter overflow
+enum {
+  I2C_SLAVE_CHECK_ADDRESS,
+  I2C_SLAVE_SEND_DATA,
+  I2C_SLAVE_REQUEST_ACK, // Data byte sent, read the master's (N)ACK
+  I2C_SLAVE_CHECK_ACK,
+  I2C_SLAVE_REQUEST_DATA,
+  I2C_SLAVE_GET_DATA,
+};
+
+// USICR: two-wire mode, SCL held low on start only / on start and overflow
+#define I2C_SLAVE_USICR_IDLE                                                   \
+  ((1 << USISIE) | (1 << USIWM1) | (1 << USICS1))
+#define I2C_SLAVE_USICR_ACTIVE                                                 \
+  ((1 << USISIE) | (1 << USIOIE) | (1 << USIWM1) | (1 << USIWM0) |            \
+   (1 << USICS1))
+
+// USISR: clear flags except start, count 16 edges (8 bits) or 2 (1 bit)
+#define I2C_SLAVE_USISR_8BIT ((1 << USIOIF) | (1 << USIPF) | (1 << USIDC))
+#define I2C_SLAVE_USISR_1BIT                                                   \
+  ((1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0x0E))
+
+// Double-buffered snapshot: the ISR reads i2c_slave_snapshot[front] while
+// the main loop fills the other one
+static volatile uint8_t i2c_slave_snapshot[2][I2C_SLAVE_SNAPSHOT_SIZE];
+static volatile uint8_t i2c_slave_front = 0;
+
+// Override registers, written by the host
+static volatile uint8_t i2c_slave_forced = 0;
+static volatile uint8_t i2c_slave_forced_duty = 0;
+static volatile uint8_t i2c_slave_forced_ttl = 0; // Passes left
+
+// Transfer state, only used in the ISRs
+static uint8_t i2c_slave_state;
+static uint8_t i2c_slave_buffer;  // Snapshot latched for this transfer
+static uint8_t i2c_slave_pointer; // Register pointer
+static uint8_t i2c_slave_first;   // Next byte written is the pointer
+
+/**
+ * Release SDA and wait for the next start condition.
+ */
+static inline void i2c_slave_idle(void) {
+  I2C_DDR &= ~(1 << I2C_SDA);
+  USICR = I2C_SLAVE_USICR_IDLE;
+  USISR = I2C_SLAVE_USISR_8BIT;
+}
+
+/**
+ * Pull SDA low for one bit: ACK a received byte.
+ */
+static inline void i2c_slave_send_ack(void) {
+  USIDR = 0;
+  I2C_DDR |= (1 << I2C_SDA);
+  USISR = I2C_SLAVE_USISR_1BIT;
+}
+
+/**
+ * Enable the USI as I2C slave on I2C_SLAVE_ADDRESS. The dynamic registers
+ * other than ID read 0 until the first i2c_slave_publish().
+ */
+void i2c_slave_init(void) {
+  i2c_slave_snapshot[0][I2C_SLAVE_REG_ID] = I2C_SLAVE_ID;
+  i2c_slave_snapshot[1][I2C_SLAVE_REG_ID] = I2C_SLAVE_ID;
+
+  I2C_PORT |= (1 << I2C_SDA) | (1 << I2C_SCL);
+  I2C_DDR |= (1 << I2C_SCL); // Held low by the USI only, open drain
+  i2c_slave_idle();
+  USISR = (1 << USISIF) | I2C_SLAVE_USISR_8BIT;
+}
+
+/**
+ * Publish the values of this control pass to the host. Called from the
+ * main loop; fills the back buffer then swaps, so a transfer in progress
+ * keeps reading the buffer it started with.
+ *
+ * @param temp Zone 0 filtered temperature, 1/16 °C
+ * @param duty Zone 0 PWM duty cycle (0-65535)
+ * @param rpm Fan speed
+ * @param status I2C_SLAVE_STATUS_* flags
+ */
+void i2c_slave_publish(int16_t temp, uint16_t duty, uint16_t rpm,
+                       uint8_t status) {
+  uint8_t back = i2c_slave_front ^ 1;
+  volatile uint8_t *regs = i2c_slave_snapshot[back];
+
+  regs[I2C_SLAVE_REG_ID] = I2C_SLAVE_ID;
+  regs[I2C_SLAVE_REG_STATUS] = status;
+  regs[I2C_SLAVE_REG_TEMP] = (uint8_t)temp;
+  regs[I2C_SLAVE_REG_TEMP + 1] = (uint8_t)((uint16_t)temp >> 8);
+  regs[I2C_SLAVE_REG_DUTY] = (uint8_t)duty;
+  regs[I2C_SLAVE_REG_DUTY + 1] = (uint8_t)(duty >> 8);
+  regs[I2C_SLAVE_REG_RPM] = (uint8_t)rpm;
+  regs[I2C_SLAVE_REG_RPM + 1] = (uint8_t)(rpm >> 8);
+
+  i2c_slave_front = back; // Single byte write, atomic
+}
+
+/**
+ * Get the host override for this control pass, once per pass. Counts down
+ * the override lifetime and drops it when the host stops refreshing it.
+ *
+ * @param duty Receives the forced PWM duty cycle (0-65535) if active
+ * @return 1 if the host overrides the fan curves, 0 otherwise
+ */
+uint8_t i2c_slave_override(uint16_t *duty) {
+  uint8_t sreg = SREG;
+  cli();
+
+  if (i2c_slave_forced_ttl) {
+    i2c_slave_forced_ttl--;
+  } else {
+    i2c_slave_forced = 0; // Expired
+  }
+  uint8_t active = i2c_slave_forced;
+  *duty = i2c_slave_forced_duty * 257U;
+
+  SREG = sreg;
+  return active;
+}
+
+/**
+ * @param reg Register address
+ * @return Register value for the host
+ */
+static uint8_t i2c_slave_read_register(uint8_t reg) {
+  if (reg < I2C_SLAVE_SNAPSHOT_SIZE) {
+    return i2c_slave_snapshot[i2c_slave_buffer][reg];
+  }
+
+  switch (reg) {
+  case I2C_SLAVE_REG_OVERRIDE_CTRL:
+    return i2c_slave_forced;
+  case I2C_SLAVE_REG_OVERRIDE_DUTY:
+    return i2c_slave_forced_duty;
+  case I2C_SLAVE_REG_CURVE_COUNT:
+    return fan_curve_default.count;
+  }
+
+  uint8_t point = (uint8_t)(reg - I2C_SLAVE_REG_CURVE) >> 1;
+  if (reg >= I2C_SLAVE_REG_CURVE && point < I2C_SLAVE_CURVE_POINTS &&
+      point < fan_curve_default.count) {
+    const fan_curve_point_t *p = &fan_curve_default.points[point];
+    return (reg & 1) ? p->pwm_duty : (uint8_t)p->temperature;
+  }
+
+  return 0xFF;
+}
+
+/**
+ * @param reg Register address, writes to read-only registers are ignored
+ * @param data Value written by the host
+ */
+static void i2c_slave_write_register(uint8_t reg, uint8_t data) {
+  if (reg == I2C_SLAVE_REG_OVERRIDE_CTRL) {
+    i2c_slave_forced = (data != 0);
+  } else if (reg == I2C_SLAVE_REG_OVERRIDE_DUTY) {
+    i2c_slave_forced_duty = data;
+  } else {
+    return;
+  }
+  i2c_slave_forced_ttl = I2C_SLAVE_OVERRIDE_PASSES;
+}
+
+/**
+ * Start condition: get ready to receive the address byte.
+ */
+ISR(USI_START_vect) {
+  uint8_t retry_count = I2C_RETRY_COUNT;
+
+  i2c_slave_state = I2C_SLAVE_CHECK_ADDRESS;
+  I2C_DDR &= ~(1 << I2C_SDA);
+
+  // Wait for the master to pull SCL low, or for a stop condition; at most
+  // I2C_RETRY_COUNT polls (0.1-0.4 ms), so a stuck bus cannot hang the ISR
+  while ((I2C_PIN & (1 << I2C_SCL)) && !(I2C_PIN & (1 << I2C_SDA))) {
+    if (--retry_count == 0) {
+      break; // Bus stuck in the start condition: give up, wait for another
+    }
+  }
+
+  if ((I2C_PIN & (1 << I2C_SDA)) || retry_count == 0) {
+    USICR = I2C_SLAVE_USICR_IDLE; // Stop: nothing to receive
+  } else {
+    USICR = I2C_SLAVE_USICR_ACTIVE;
+  }
+  USISR = (1 << USISIF) | I2C_SLAVE_USISR_8BIT;
+}
+
+/**
+ * Counter overflow: a byte or an (N)ACK bit has been shifted. SCL is held
+ * low until USISR is written, stretching the clock while this runs.
+ */
+ISR(USI_OVF_vect) {
+  switch (i2c_slave_state) {
+  case I2C_SLAVE_CHECK_ADDRESS:
+    if ((USIDR >> 1) != I2C_SLAVE_ADDRESS) {
+      i2c_slave_idle(); // Not for us
+      return;
+    }
+    if (USIDR & I2C_READ) {
+      i2c_slave_state = I2C_SLAVE_SEND_DATA;
+    } else {
+      i2c_slave_state = I2C_SLAVE_REQUEST_DATA;
+      i2c_slave_first = 1;
+    }
+    i2c_slave_buffer = i2c_slave_front;
+    i2c_slave_send_ack();
+    break;
+
+  case I2C_SLAVE_CHECK_ACK:
+    if (USIDR) {
+      i2c_slave_idle(); // NACK: the master wants no more data
+      return;
+    }
+    // fall through
+  case I2C_SLAVE_SEND_DATA:
+    USIDR = i2c_slave_read_register(i2c_slave_pointer++);
+    i2c_slave_state = I2C_SLAVE_REQUEST_ACK;
+    I2C_DDR |= (1 << I2C_SDA);
+    USISR = I2C_SLAVE_USISR_8BIT;
+    break;
+
+  case I2C_SLAVE_REQUEST_ACK:
+    i2c_slave_state = I2C_SLAVE_CHECK_ACK;
+    I2C_DDR &= ~(1 << I2C_SDA);
+    USIDR = 0;
+    USISR = I2C_SLAVE_USISR_1BIT;
+    break;
+
+  case I2C_SLAVE_REQUEST_DATA:
+    i2c_slave_state = I2C_SLAVE_GET_DATA;
+    I2C_DDR &= ~(1 << I2C_SDA);
+    USISR = I2C_SLAVE_USISR_8BIT;
+    break;
+
+  case I2C_SLAVE_GET_DATA:
+    if (i2c_slave_first) {
+      i2c_slave_pointer = USIDR;
+      i2c_slave_first = 0;
+    } else {
+      i2c_slave_write_register(i2c_slave_pointer++, USIDR);
+    }
+    i2c_slave_state = I2C_SLAVE_REQUEST_DATA;
+    i2c_slave_send_ack();
+    break;
+  }
+}
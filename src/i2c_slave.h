@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_I2C_SLAVE_H_
+#define TINY85FANCONTROL_SRC_I2C_SLAVE_H_
+
+/**
+ * I2C (TWI) slave register interface on the ATtiny85 USI, after Atmel
+ * application note AVR312, for a host or BMC to monitor and override the
+ * controller.
+ *
+ * The slave is driven entirely by the USI start condition and counter
+ * overflow interrupts. A host transaction never waits on the control loop:
+ * reads are served from a double-buffered snapshot that the main loop
+ * publishes once per pass, and override writes only set two bytes that the
+ * main loop picks up on its next pass.
+ *
+ * Protocol: the first byte written after the address sets the register
+ * pointer, further bytes written go to the register (only OVERRIDE_* are
+ * writable). Reads return bytes from the register pointer. The pointer
+ * increments after every byte, so a block read of 0x00-0x07 gets a
+ * coherent snapshot. Unused registers read 0xFF.
+ *
+ * Register map (16-bit values little-endian):
+ *  0x00     ID            0x85
+ *  0x01     STATUS        I2C_SLAVE_STATUS_* flags
+ *  0x02-03  TEMP          zone 0 filtered temperature, 1/16 °C (signed)
+ *  0x04-05  DUTY          zone 0 PWM duty cycle (0-65535)
+ *  0x06-07  RPM           fan speed from the tach
+ *  0x08     OVERRIDE_CTRL 1 = force OVERRIDE_DUTY on all zones, 0 = curves
+ *  0x09     OVERRIDE_DUTY forced duty cycle (0-255)
+ *  0x0A     CURVE_COUNT   points in the default fan curve
+ *  0x10-1F  CURVE         curve points: temperature (°C, signed), duty
+ *
+ * An override expires after I2C_SLAVE_OVERRIDE_PASSES control passes unless
+ * the host writes one of the OVERRIDE_* registers again, so a hung host
+ * cannot leave the fans stuck.
+ *
+ * The USI pins are fixed (SDA PB0, SCL PB2). With the 1-Wire bus on PB1 and
+ * the tach on PB3 no pin is left for UART TX, so the UART must be disabled,
+ * and PWM must use Timer1 (PB4). The USI cannot serve the I2C sensor at
+ * the same time, so the sensor must be the DS18B20.
+ */
+
+#include <stdint.h>
+
+// Build with the I2C slave interface
+#ifndef I2C_SLAVE_ENABLE
+#define I2C_SLAVE_ENABLE 0
+#endif
+
+// 7-bit slave address
+#ifndef I2C_SLAVE_ADDRESS
+#define I2C_SLAVE_ADDRESS (0x2E)
+#endif
+
+// Control passes an override lasts without a refresh (~80 s)
+#ifndef I2C_SLAVE_OVERRIDE_PASSES
+#define I2C_SLAVE_OVERRIDE_PASSES (30)
+#endif
+
+#define I2C_SLAVE_ID (0x85)
+
+// Registers
+#define I2C_SLAVE_REG_ID (0x00)
+#define I2C_SLAVE_REG_STATUS (0x01)
+#define I2C_SLAVE_REG_TEMP (0x02)
+#define I2C_SLAVE_REG_DUTY (0x04)
+#define I2C_SLAVE_REG_RPM (0x06)
+#define I2C_SLAVE_REG_OVERRIDE_CTRL (0x08)
+#define I2C_SLAVE_REG_OVERRIDE_DUTY (0x09)
+#define I2C_SLAVE_REG_CURVE_COUNT (0x0A)
+#define I2C_SLAVE_REG_CURVE (0x10)
+#define I2C_SLAVE_CURVE_POINTS (8) // Registers 0x10-0x1F
+
+// STATUS flags
+#define I2C_SLAVE_STATUS_SENSOR_ERROR (1 << 0) // A sensor read failed
+#define I2C_SLAVE_STATUS_STALL (1 << 1)        // Fan driven but not turning
+#define I2C_SLAVE_STATUS_OVERRIDE (1 << 2)     // Host override in effect
+
+void i2c_slave_init(void);
+void i2c_slave_publish(int16_t temp, uint16_t duty, uint16_t rpm,
+                       uint8_t status);
+uint8_t i2c_slave_override(uint16_t *duty);
+
+#endif /* TINY85FANCONTROL_SRC_I2C_SLAVE_H_ */
@@ -24,48 +24,113 @@
  *
  */
 
-#include "ds18b20.h"
 #include "pwm.h"
-#include "fan_curve.h"
+#include "clock.h"
+#include "fan_zone.h"
+#include "i2c_slave.h"
+#include "profile.h"
+#include "sensor.h"
+#include "stats.h"
+#include "tach.h"
 #include "temp_sensor.h"
 #include "uart.h"
 
+#include <avr/interrupt.h>
 #include <avr/io.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 
 #define BUILD_VERSION "1.0.0"
 
+// Wait between control passes; the next conversion runs during it
+#define CONTROL_INTERVAL_MS SENSOR_INTERVAL_MS
+
 int main(void) {
   pwm_init();         // Initialize PWM
+  profile_init();     // Profiling build: start the free timer
   uart_init();        // Initialize UART
   temp_sensor_init(); // Initialize temperature sensor
+  fan_zone_init();    // Find the external sensors
+  tach_init();        // Initialize fan tachometer input
+  stats_init();       // Load statistics history from EEPROM
+#if I2C_SLAVE_ENABLE
+  i2c_slave_init(); // Register interface for the host
+#endif
+  sei();              // Enable interrupts (PWM dithering, tach, I2C)
+
+  uart_print_P(PSTR("Tiny85 Fan Control (Table LERP)\r\n"));
+  uart_print_P(PSTR("Build Version: " BUILD_VERSION "\r\n"));
+  uart_print_P(PSTR("System Initialized\r\n"));
+  stats_report(); // History before this boot
 
-  uart_print("Tiny85 Fan Control (Table LERP)\r\n");
-  uart_print("Build Version: " BUILD_VERSION "\r\n");
-  uart_print("System Initialized\r\n");
+  // Kick-start the fans at max duty cycle while the first conversion runs,
+  // until the tach confirms rotation (bounded for fans without tach)
+  for (uint8_t channel = 0; channel < PWM_CHANNELS; channel++) {
+    pwm_channel_set16(channel, 0xFFFF);
+  }
+  fan_zone_start();
 
-  uint8_t current_pwm_duty = 0;
-  int16_t case_temp = 0;
+  if (tach_wait_spinup()) {
+    uart_print_P(PSTR("Fan spin-up confirmed\r\n"));
+  } else {
+    uart_print_P(PSTR("Fan spin-up timeout\r\n"));
+  }
 
-  // Set the PWM to max duty cycle initially until fan ramps up
-  pwm_set(255);
-  _delay_ms(9999);
+  uint16_t rpm = 0;
 
   for (;;) {
-    case_temp = ds18b20_read_celsius();
+#if I2C_SLAVE_ENABLE
+    uint16_t forced_duty;
+    uint8_t forced = i2c_slave_override(&forced_duty);
+    fan_zone_override(forced, forced_duty);
+#endif
+
+    uint8_t errors = fan_zone_update(); // Read all sensors, update zones
+
+    profile_start(PROFILE_UART);
+    for (uint8_t zone = 0; zone < FAN_ZONE_COUNT; zone++) {
+#if FAN_ZONE_COUNT > 1
+      uart_print_P(PSTR("Zone "));
+      uart_print_dec16(zone);
+      uart_print_P(PSTR(": "));
+#endif
+      uart_print_P(PSTR("Current Temp = "));
+      uart_print_dec16(sensor_raw_to_celsius(fan_zone_temp(zone)));
+      uart_print_P(PSTR(" C, "));
+
+      uart_print_P(PSTR("PWM Duty Cycle = "));
+      uart_print_dec16(fan_zone_duty(zone) >> 8);
+      uart_print_P(PSTR("\r\n"));
+    }
+
+    uart_print_P(PSTR("Fan Speed = "));
+    uart_print_udec32(rpm);
+    uart_print_P(PSTR(" RPM\r\n"));
+    profile_stop(PROFILE_UART);
 
-    uart_print("Current Temp = ");
-    uart_print_dec16(case_temp);
-    uart_print(" C, ");
+    uint16_t duty = fan_zone_duty(0);
+    uint8_t stalled = tach_stalled(duty != 0);
+    if (stats_sample(fan_zone_temp(0), duty, errors, stalled)) {
+      stats_report(); // Report each time the history is flushed
+    }
 
-    current_pwm_duty = fan_curve_compute_pwm(case_temp);
+#if I2C_SLAVE_ENABLE
+    uint8_t status = 0;
+    if (errors)
+      status |= I2C_SLAVE_STATUS_SENSOR_ERROR;
+    if (stalled)
+      status |= I2C_SLAVE_STATUS_STALL;
+    if (forced)
+      status |= I2C_SLAVE_STATUS_OVERRIDE;
+    i2c_slave_publish(fan_zone_temp(0), duty, rpm, status);
+#endif
 
-    pwm_set(current_pwm_duty);
-    uart_print("PWM Duty Cycle = ");
-    uart_print_dec16(current_pwm_duty);
-    uart_print("\r\n");
+    profile_pass(); // Profiling build: periodic report
 
-    _delay_ms(2000); // Delay for a longer period (e.g., 2 seconds)
+    // Idle at reduced clock until the next pass, measuring the fan speed
+    fan_zone_start();
+    clock_slow();
+    rpm = tach_measure_rpm(CONTROL_INTERVAL_MS);
+    clock_fast();
   }
 
   return 0; // This line will never be reached
@@ -24,6 +24,7 @@
  *
  */
 #include "onewire.h"
+#include "profile.h"
 
 #include <avr/interrupt.h>
 #include <avr/io.h>
@@ -57,11 +58,13 @@
   do {                                                                         \
     sreg = SREG;                                                               \
     cli();                                                                     \
+    profile_irq_off();                                                         \
   } while (0)
 
 // Restore previous state of interrupts
 #define CRITICAL_SECTION_END(sreg)                                             \
   do {                                                                         \
+    profile_irq_on();                                                          \
     SREG = sreg;                                                               \
   } while (0)
 
@@ -74,6 +77,8 @@ uint8_t onewire_reset(void) {
   uint8_t retry_count = ONEWIRE_RETRY_COUNT;
   uint8_t sreg;
 
+  profile_start(PROFILE_RESET);
+
   // Initialize pin state
   ONEWIRE_SET_LOW;    // Ensure output is low when driving
   ONEWIRE_MODE_INPUT; // Start as input
@@ -81,6 +86,7 @@ uint8_t onewire_reset(void) {
   while (!ONEWIRE_READ_STATE) {
     if (retry_count == 0) {
       // Error: bus is stuck low, return error code
+      profile_stop(PROFILE_RESET);
       return ONEWIRE_ERROR;
     }
 
@@ -104,43 +110,74 @@ uint8_t onewire_reset(void) {
 
   CRITICAL_SECTION_END(sreg);
 
+  profile_stop(PROFILE_RESET);
   return presence ? ONEWIRE_LOW : ONEWIRE_HIGH; // Return presence status
 }
 
 /**
- * @brief Performs a read-write operation on the OneWire bus
+ * @brief Transfers up to 8 bits on the OneWire bus, LSB first
+ *
+ * Each bit is one standard-speed time slot, timed by counted cycles in a
+ * single asm block, so the timing does not depend on the compiler or on
+ * CPU_OPTIM. Interrupts are masked from the falling edge to the end of the
+ * slot and enabled again during recovery. Expects the port bit low, as left
+ * by onewire_reset().
  *
- * This function writes a single bit to the OneWire bus and reads the state of
- * the bus
+ * Cycles from the falling edge (end of sbi), N = loop count of the label:
+ *   release  4*N2 + 4           (write 1 / read; skipped for a 0)
+ *   sample   release + 4*N3 + 2
+ *   slot end sample + 4*N4 + 5  (write 0 released here)
+ *   recovery 4*N5 + 9 to the next falling edge
+ * A 0 bit skips the cbi, so its later events come 1 cycle earlier.
  *
- * @param bit The bit to write (0 or 1)
+ * @param data Bits to write, LSB first
+ * @param bits Number of bits to transfer (1 to 8)
  *
- * @return uint8_t The bit read from the bus after writing
+ * @return uint8_t Bits read, shifted in from the MSB
  */
-static uint8_t onewire_rw_bit(uint8_t bit) {
+static inline uint8_t onewire_rw_bits(uint8_t data, uint8_t bits) {
   uint8_t sreg;
-  CRITICAL_SECTION_START(sreg);
-
-  ONEWIRE_MODE_OUTPUT; // Set pin as output, state A
-  _delay_us(1);        // Wait for 2 us, state A
-
-  if (bit) {
-    ONEWIRE_MODE_INPUT; // Set pin as input, state B
-  }
-
-  // For write 0: keep driving low
-  _delay_us(14); // Wait for 14 us, state B
-
-  // Read the pin state
-  uint8_t state = ONEWIRE_READ_STATE; // Read the pin state, state C
+  uint16_t count;
+
+  __asm__ __volatile__(
+      "1:  in   %[sreg], __SREG__\n\t"
+      "    cli\n\t"
+      "    sbi  %[ddr], %[bit]\n\t" // Drive low, slot starts
+      "    ldi  %A[count], lo8(%[n_low])\n\t"
+      "    ldi  %B[count], hi8(%[n_low])\n\t"
+      "2:  sbiw %[count], 1\n\t"
+      "    brne 2b\n\t"
+      "    sbrc %[data], 0\n\t"
+      "    cbi  %[ddr], %[bit]\n\t" // Release for a 1 or a read
+      "    ldi  %A[count], lo8(%[n_sample])\n\t"
+      "    ldi  %B[count], hi8(%[n_sample])\n\t"
+      "3:  sbiw %[count], 1\n\t"
+      "    brne 3b\n\t"
+      "    lsr  %[data]\n\t"
+      "    sbic %[pin], %[bit]\n\t" // Sample the bus
+      "    ori  %[data], 0x80\n\t"
+      "    ldi  %A[count], lo8(%[n_slot])\n\t"
+      "    ldi  %B[count], hi8(%[n_slot])\n\t"
+      "4:  sbiw %[count], 1\n\t"
+      "    brne 4b\n\t"
+      "    cbi  %[ddr], %[bit]\n\t" // Release for a 0, slot ends
+      "    out  __SREG__, %[sreg]\n\t"
+      "    ldi  %A[count], lo8(%[n_recovery])\n\t"
+      "    ldi  %B[count], hi8(%[n_recovery])\n\t"
+      "5:  sbiw %[count], 1\n\t"
+      "    brne 5b\n\t"
+      "    dec  %[bits]\n\t"
+      "    brne 1b\n\t"
+      : [data] "+d"(data), [bits] "+r"(bits), [sreg] "=&r"(sreg),
+        [count] "=&w"(count)
+      : [ddr] "I"(_SFR_IO_ADDR(ONEWIRE_DDR)),
+        [pin] "I"(_SFR_IO_ADDR(ONEWIRE_PIN)), [bit] "I"(ONEWIRE_BIT),
+        [n_low] "n"(ONEWIRE_LOOPS_LOW), [n_sample] "n"(ONEWIRE_LOOPS_SAMPLE),
+        [n_slot] "n"(ONEWIRE_LOOPS_SLOT),
+        [n_recovery] "n"(ONEWIRE_LOOPS_RECOVERY)
+      : "memory");
 
-  _delay_us(45); // Complete the time slot (total ~60us)
-
-  ONEWIRE_MODE_INPUT; // Set pin as input again, state D
-
-  CRITICAL_SECTION_END(sreg);
-
-  return state ? ONEWIRE_HIGH : ONEWIRE_LOW; // Return the read state
+  return data;
 }
 
 /**
@@ -150,18 +187,8 @@ static uint8_t onewire_rw_bit(uint8_t bit) {
  *
  * @return uint8_t Data read from the bus after writing
  */
-static uint8_t onewire_rw_byte(uint8_t data) {
-  for (uint8_t i = 0; i < 8; ++i) {
-    // Write the LSB of the byte and read the bus state
-    uint8_t bit_read = onewire_rw_bit(data & 1);
-    data >>= 1;
-
-    if (bit_read) {
-      data |= 0x80;
-    }
-  }
-
-  return data;
+static inline uint8_t onewire_rw_byte(uint8_t data) {
+  return onewire_rw_bits(data, 8);
 }
 
 /**
@@ -178,6 +205,124 @@ uint8_t onewire_read_byte(void) { return onewire_rw_byte(0xFF); }
  */
 void onewire_write_byte(uint8_t data) { (void)onewire_rw_byte(data); }
 
+/**
+ * @brief Read a single bit (time slot) from the OneWire bus
+ *
+ * @return uint8_t The bit read (0 or 1)
+ */
+uint8_t onewire_read_bit(void) { return onewire_rw_bits(1, 1) >> 7; }
+
+/**
+ * @brief Write a single bit (time slot) to the OneWire bus
+ *
+ * @param bit The bit to write (0 for 0, anything else for 1)
+ */
+void onewire_write_bit(uint8_t bit) { (void)onewire_rw_bits(!!bit, 1); }
+
+/**
+ * @brief Write a block of bytes to the OneWire bus
+ *
+ * @param data The bytes to write
+ * @param len Number of bytes
+ */
+void onewire_write_block(const uint8_t *data, uint8_t len) {
+  for (uint8_t i = 0; i < len; ++i) {
+    (void)onewire_rw_byte(data[i]);
+  }
+}
+
+/**
+ * @brief Read a block of bytes from the OneWire bus
+ *
+ * @param data Receives the bytes read
+ * @param len Number of bytes
+ */
+void onewire_read_block(uint8_t *data, uint8_t len) {
+  for (uint8_t i = 0; i < len; ++i) {
+    data[i] = onewire_rw_byte(0xFF);
+  }
+}
+
+/**
+ * @brief Find the next device on the bus (Maxim application note 187)
+ *
+ * Call with a zeroed search state to start; each call walks the next branch
+ * of the ROM tree. With ONEWIRE_CMD_SEARCH_ROM every device is found, with
+ * ONEWIRE_CMD_ALARM_SEARCH only devices with their alarm flag set respond.
+ *
+ * @param state Search state, kept between calls
+ * @param command ONEWIRE_CMD_SEARCH_ROM or ONEWIRE_CMD_ALARM_SEARCH
+ * @param rom Receives the 8-byte ROM code of the device found
+ *
+ * The search resets the bus itself, so a missing presence pulse is told
+ * apart from a search that no device answered (e.g. no alarms).
+ *
+ * @return uint8_t ONEWIRE_SEARCH_FOUND if a device was found,
+ *         ONEWIRE_SEARCH_DONE when the search is complete,
+ *         ONEWIRE_SEARCH_NO_PRESENCE if the bus did not answer the reset
+ */
+uint8_t onewire_search(onewire_search_t *state, uint8_t command,
+                       uint8_t rom[ONEWIRE_ROM_SIZE]) {
+  uint8_t last_zero = 0;
+
+  if (state->last_device) {
+    return ONEWIRE_SEARCH_DONE; // Previous call found the last device
+  }
+
+  if (onewire_reset() != ONEWIRE_LOW) {
+    return ONEWIRE_SEARCH_NO_PRESENCE; // No device present, or bus error
+  }
+
+  onewire_write_byte(command);
+
+  for (uint8_t id_bit = 1; id_bit <= ONEWIRE_ROM_SIZE * 8; ++id_bit) {
+    uint8_t byte = (id_bit - 1) >> 3;
+    uint8_t mask = 1 << ((id_bit - 1) & 7);
+    uint8_t bit = onewire_read_bit();
+    uint8_t cmp_bit = onewire_read_bit();
+    uint8_t direction;
+
+    if (bit && cmp_bit) {
+      return ONEWIRE_SEARCH_DONE; // No devices participating
+    }
+
+    if (bit != cmp_bit) {
+      direction = bit; // All remaining devices agree on this bit
+    } else {
+      // Discrepancy: repeat the previous choice before the last branch point,
+      // take 1 at it, and 0 past it
+      if (id_bit < state->last_discrepancy) {
+        direction = (state->rom[byte] & mask) ? 1 : 0;
+      } else {
+        direction = (id_bit == state->last_discrepancy);
+      }
+
+      if (!direction) {
+        last_zero = id_bit;
+      }
+    }
+
+    if (direction) {
+      state->rom[byte] |= mask;
+    } else {
+      state->rom[byte] &= ~mask;
+    }
+
+    onewire_write_bit(direction);
+  }
+
+  state->last_discrepancy = last_zero;
+  if (last_zero == 0) {
+    state->last_device = 1;
+  }
+
+  for (uint8_t i = 0; i < ONEWIRE_ROM_SIZE; ++i) {
+    rom[i] = state->rom[i];
+  }
+
+  return ONEWIRE_SEARCH_FOUND;
+}
+
 /**
  * @brief Read the state of the OneWire bus
  */
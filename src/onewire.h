@@ -36,15 +36,73 @@
 
 #define ONEWIRE_RETRY_COUNT (128)
 
+#define ONEWIRE_ROM_SIZE (8) // Family code, 48-bit serial, CRC
+
+// Standard-speed time slot, in us from the falling edge that starts it
+#define ONEWIRE_T_RELEASE (3)  // Release for a 1 or a read (1 to 15 us)
+#define ONEWIRE_T_SAMPLE (13)  // Sample the bus (device data valid to 15 us)
+#define ONEWIRE_T_SLOT (61)    // Release after a 0 (60 to 120 us)
+#define ONEWIRE_T_RECOVERY (3) // Bus released between slots (1 us min)
+
+#if F_CPU < 4000000UL
+#error "1-Wire slot timing needs F_CPU of at least 4 MHz"
+#endif
+
+#define ONEWIRE_CYCLES(us) ((F_CPU / 1000UL) * (us) / 1000UL)
+
+// Iterations of the 4-cycle delay loop to reach `cycles` after `fixed`
+// cycles of other instructions, rounded up
+#define ONEWIRE_LOOPS(cycles, fixed)                                           \
+  ((cycles) > (fixed) + 4 ? ((cycles) - (fixed) + 3) / 4 : 1)
+
+// Loop counts for onewire_rw_bits(); the sample point rounds down so it
+// never moves past ONEWIRE_T_SAMPLE. Here, not in onewire.c, so that
+// tests/test_onewire_timing.c checks the counts the firmware is built with
+#define ONEWIRE_LOOPS_LOW ONEWIRE_LOOPS(ONEWIRE_CYCLES(ONEWIRE_T_RELEASE), 4)
+#define ONEWIRE_AT_RELEASE (4 * ONEWIRE_LOOPS_LOW + 4)
+#define ONEWIRE_LOOPS_SAMPLE                                                   \
+  ((ONEWIRE_CYCLES(ONEWIRE_T_SAMPLE) - ONEWIRE_AT_RELEASE - 2) / 4)
+#define ONEWIRE_AT_SAMPLE (ONEWIRE_AT_RELEASE + 4 * ONEWIRE_LOOPS_SAMPLE + 2)
+#define ONEWIRE_LOOPS_SLOT                                                     \
+  ONEWIRE_LOOPS(ONEWIRE_CYCLES(ONEWIRE_T_SLOT), ONEWIRE_AT_SAMPLE + 5)
+#define ONEWIRE_LOOPS_RECOVERY                                                 \
+  ONEWIRE_LOOPS(ONEWIRE_CYCLES(ONEWIRE_T_RECOVERY), 9)
+
+// ROM commands
+#define ONEWIRE_CMD_SEARCH_ROM (0xF0)
+#define ONEWIRE_CMD_MATCH_ROM (0x55)
+#define ONEWIRE_CMD_SKIP_ROM (0xCC)
+#define ONEWIRE_CMD_ALARM_SEARCH (0xEC)
+
 enum {
     ONEWIRE_LOW = 0,
     ONEWIRE_HIGH = 1,
     ONEWIRE_ERROR = 2,
 };
 
+// Result of onewire_search()
+enum {
+    ONEWIRE_SEARCH_DONE = 0,        // No (more) devices answered
+    ONEWIRE_SEARCH_FOUND = 1,       // A device was found, ROM code returned
+    ONEWIRE_SEARCH_NO_PRESENCE = 2, // No presence pulse, or bus error
+};
+
+// State of an ongoing ROM search, zero it to start a new search
+typedef struct {
+    uint8_t rom[ONEWIRE_ROM_SIZE];
+    uint8_t last_discrepancy;
+    uint8_t last_device;
+} onewire_search_t;
+
 uint8_t onewire_reset(void);
 uint8_t onewire_read_byte(void);
 bool onewire_read_bus(void);
 void onewire_write_byte(uint8_t data);
+uint8_t onewire_read_bit(void);
+void onewire_write_bit(uint8_t bit);
+void onewire_write_block(const uint8_t *data, uint8_t len);
+void onewire_read_block(uint8_t *data, uint8_t len);
+uint8_t onewire_search(onewire_search_t *state, uint8_t command,
+                       uint8_t rom[ONEWIRE_ROM_SIZE]);
 
 #endif // TINY85FANCONTROL_ONEWIRE_H_
\ No newline at end of file
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "profile.h"
+#include "pwm.h"
+#include "uart.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#if PWM_CHANNELS > 1
+#error "Profiling needs a free timer: use PWM_CHANNELS 1"
+#endif
+
+#if !UART_ENABLE
+#error "Profiling reports on the UART: set UART_ENABLE to 1"
+#endif
+
+#if PWM_BACKEND == PWM_BACKEND_TIMER0
+#define PROFILE_TCNT TCNT1
+#define PROFILE_TOV TOV1
+#define PROFILE_TOIE TOIE1
+#define PROFILE_OVF_vect TIMER1_OVF_vect
+#define PROFILE_TICK_SHIFT (7) // CK/128: overflow every 2 ms at 16 MHz
+#else
+#define PROFILE_TCNT TCNT0
+#define PROFILE_TOV TOV0
+#define PROFILE_TOIE TOIE0
+#define PROFILE_OVF_vect TIMER0_OVF_vect
+#define PROFILE_TICK_SHIFT (8) // CK/256: overflow every 4 ms at 16 MHz
+#endif
+
+// Durations of one stage, in timer ticks
+typedef struct {
+  uint16_t min;
+  uint16_t max;
+  uint32_t sum;
+  uint16_t count;
+} profile_stage_t;
+
+static const char profile_name_reset[] PROGMEM = "reset";
+static const char profile_name_scratchpad[] PROGMEM = "scratchpad";
+static const char profile_name_curve[] PROGMEM = "curve";
+static const char profile_name_uart[] PROGMEM = "uart";
+
+// Stage names, in flash like the table itself
+static const char *const profile_names[PROFILE_STAGES] PROGMEM = {
+    profile_name_reset, profile_name_scratchpad,
+    profile_name_curve, profile_name_uart,
+};
+
+static profile_stage_t profile_stages[PROFILE_STAGES];
+static uint16_t profile_started[PROFILE_STAGES];
+static uint16_t profile_irq_started;
+static uint16_t profile_irq_max;
+static uint8_t profile_passes;
+static volatile uint8_t profile_overflows; // High byte of the timestamp
+
+/**
+ * @return Ticks since profile_init(), modulo 2^16
+ */
+static uint16_t profile_now(void) {
+  uint8_t sreg = SREG;
+  cli();
+  uint8_t high = profile_overflows;
+  uint8_t low = PROFILE_TCNT;
+  if (TIFR & (1 << PROFILE_TOV)) {
+    low = PROFILE_TCNT; // Overflow not counted yet: read again after it
+    high++;
+  }
+  SREG = sreg;
+
+  return (uint16_t)(high << 8) | low;
+}
+
+/**
+ * Clear all statistics for the next report.
+ */
+static void profile_clear(void) {
+  for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+    profile_stages[i].min = 0xFFFF;
+    profile_stages[i].max = 0;
+    profile_stages[i].sum = 0;
+    profile_stages[i].count = 0;
+  }
+  profile_irq_max = 0;
+}
+
+/**
+ * Start the free timer as a timebase. Call after pwm_init().
+ */
+void profile_init(void) {
+#if PWM_BACKEND == PWM_BACKEND_TIMER0
+  TCCR1 = (1 << CS13); // Timer1 normal mode, CK/128
+#else
+  TCCR0A = 0;           // Timer0 normal mode
+  TCCR0B = (1 << CS02); // CK/256
+#endif
+  TIMSK |= (1 << PROFILE_TOIE);
+  profile_clear();
+}
+
+/**
+ * Mark the start of a stage.
+ *
+ * @param stage PROFILE_* stage
+ */
+void profile_start(uint8_t stage) { profile_started[stage] = profile_now(); }
+
+/**
+ * Mark the end of a stage and add its duration to the statistics.
+ *
+ * @param stage PROFILE_* stage, started with profile_start()
+ */
+void profile_stop(uint8_t stage) {
+  uint16_t ticks = profile_now() - profile_started[stage];
+  profile_stage_t *s = &profile_stages[stage];
+
+  if (ticks < s->min)
+    s->min = ticks;
+  if (ticks > s->max)
+    s->max = ticks;
+  if (s->count < 0xFFFF) {
+    s->sum += ticks;
+    s->count++;
+  }
+}
+
+/**
+ * Mark the start of a critical section, right after cli().
+ */
+void profile_irq_off(void) { profile_irq_started = profile_now(); }
+
+/**
+ * Mark the end of a critical section, right before interrupts come back.
+ */
+void profile_irq_on(void) {
+  uint16_t ticks = profile_now() - profile_irq_started;
+
+  if (ticks > profile_irq_max)
+    profile_irq_max = ticks;
+}
+
+/**
+ * Count a control pass; every PROFILE_REPORT_PASSES print the statistics
+ * (in CPU cycles) and start over.
+ */
+void profile_pass(void) {
+  if (++profile_passes < PROFILE_REPORT_PASSES) {
+    return;
+  }
+  profile_passes = 0;
+
+  for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+    const profile_stage_t *s = &profile_stages[i];
+    if (!s->count) {
+      continue;
+    }
+    uart_print_P(PSTR("Prof: "));
+    uart_print_P((const char *)pgm_read_ptr(&profile_names[i]));
+    uart_print_P(PSTR(" min="));
+    uart_print_udec32((uint32_t)s->min << PROFILE_TICK_SHIFT);
+    uart_print_P(PSTR(" max="));
+    uart_print_udec32((uint32_t)s->max << PROFILE_TICK_SHIFT);
+    uart_print_P(PSTR(" avg="));
+    uart_print_udec32((s->sum << PROFILE_TICK_SHIFT) / s->count);
+    uart_print_P(PSTR(" n="));
+    uart_print_udec32(s->count);
+    uart_print_P(PSTR("\r\n"));
+  }
+  uart_print_P(PSTR("Prof: irq max="));
+  uart_print_udec32((uint32_t)profile_irq_max << PROFILE_TICK_SHIFT);
+  uart_print_P(PSTR(" cycles\r\n"));
+
+  profile_clear();
+}
+
+/**
+ * Timer overflow: extend the 8-bit counter.
+ */
+ISR(PROFILE_OVF_vect) { profile_overflows++; }
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_PROFILE_H_
+#define TINY85FANCONTROL_SRC_PROFILE_H_
+
+/**
+ * Hot-path profiler, for profiling builds only (PROFILE_ENABLE).
+ *
+ * Each stage of the control pass is wrapped in profile_start() /
+ * profile_stop(), which read a timestamp from the timer that PWM leaves
+ * free (Timer1 with PWM_BACKEND_TIMER0, Timer0 with PWM_BACKEND_TIMER1).
+ * Per stage the profiler keeps the min / max / average duration in CPU
+ * cycles; stages may nest (a scratchpad read includes its resets).
+ * The critical sections of the 1-Wire and UART drivers report their
+ * length with profile_irq_off() / profile_irq_on() for the worst
+ * interrupts-masked span. profile_pass() prints all of it on the UART
+ * every PROFILE_REPORT_PASSES passes and starts over.
+ *
+ * The timer prescaler is chosen so that one overflow is longer than the
+ * longest masked span (a UART byte, ~1 ms), so no overflow is lost. This
+ * makes a timer tick 128 (Timer1) or 256 (Timer0) cycles; stage start
+ * times have no fixed phase to the timer, so averages are still accurate
+ * to a few cycles over many passes, min / max to one tick. Timestamps are
+ * 16 bits to keep the profiler at ~55 bytes of RAM, so a stage must take
+ * less than 2^16 ticks (0.5 s with Timer1, 1 s with Timer0).
+ *
+ * With PROFILE_ENABLE 0 (the default) all calls compile to nothing.
+ */
+
+#include <stdint.h>
+
+// Build with the profiler
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 0
+#endif
+
+// Control passes between reports (~90 s)
+#ifndef PROFILE_REPORT_PASSES
+#define PROFILE_REPORT_PASSES (32)
+#endif
+
+// Profiled stages
+enum {
+  PROFILE_RESET,      // 1-Wire reset and presence pulse
+  PROFILE_SCRATCHPAD, // Reading the scratchpad of one sensor
+  PROFILE_CURVE,      // Fan curve evaluation of one zone
+  PROFILE_UART,       // Status output of one pass
+  PROFILE_STAGES,
+};
+
+#if PROFILE_ENABLE
+void profile_init(void);
+void profile_start(uint8_t stage);
+void profile_stop(uint8_t stage);
+void profile_irq_off(void);
+void profile_irq_on(void);
+void profile_pass(void);
+#else
+static inline void profile_init(void) {}
+static inline void profile_start(uint8_t stage) { (void)stage; }
+static inline void profile_stop(uint8_t stage) { (void)stage; }
+static inline void profile_irq_off(void) {}
+static inline void profile_irq_on(void) {}
+static inline void profile_pass(void) {}
+#endif
+
+#endif /* TINY85FANCONTROL_SRC_PROFILE_H_ */
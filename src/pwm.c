@@ -26,7 +26,65 @@
 
 #include "pwm.h"
 
+#include <avr/interrupt.h>
 #include <avr/io.h>
+#include <util/delay.h>
+
+#define PWM_USE_TIMER0 (PWM_BACKEND == PWM_BACKEND_TIMER0 || PWM_CHANNELS > 1)
+#define PWM_USE_TIMER1 (PWM_BACKEND == PWM_BACKEND_TIMER1 || PWM_CHANNELS > 1)
+
+#if PWM_USE_TIMER1
+
+// Sigma-delta dither state of one channel, shared with its overflow ISR
+typedef struct {
+  volatile uint8_t base; // Integer part of the duty (compare value)
+  volatile uint8_t frac; // Fractional part (1/256 step)
+  uint8_t acc;           // Accumulator, only touched by the ISR
+} pwm_dither_t;
+
+/**
+ * Split a 16-bit duty into compare value and fraction for a timer with
+ * `steps` compare steps per period, and store both atomically.
+ *
+ * @return The compare value (integer part).
+ */
+static uint8_t pwm_dither_split(pwm_dither_t *d, uint16_t duty,
+                                uint16_t steps) {
+  // duty * steps / 256 as 8.8 fixed point: compare value . fraction
+  uint16_t scaled = (uint16_t)(((uint32_t)duty * steps) >> 8);
+  uint8_t base = (uint8_t)(scaled >> 8);
+
+  uint8_t sreg = SREG;
+  cli(); // Base and fraction must change together
+  d->base = base;
+  d->frac = (uint8_t)scaled;
+  SREG = sreg;
+
+  return base;
+}
+
+/**
+ * Pick the compare value for the next PWM period.
+ *
+ * First-order sigma-delta: the fraction is accumulated every period and the
+ * carry out of the accumulator adds one compare step. Fixed cost of a few
+ * instructions per period, no loops.
+ */
+static inline uint8_t pwm_dither_next(pwm_dither_t *d) {
+  uint8_t base = d->base;
+  uint8_t sum = d->acc + d->frac;
+
+  if (sum < d->acc && base != 0xFF) {
+    base++; // Carry: one step up for this period
+  }
+  d->acc = sum;
+
+  return base;
+}
+
+#endif /* PWM_USE_TIMER1 */
+
+#if PWM_USE_TIMER0
 
 /**
  * Initialize Timer0 for 8-bit Fast PWM on OC0A (PB0).
@@ -36,32 +94,230 @@
  * 2. Configure Timer0 for Fast PWM (Mode 3): set WGM01 and WGM00.
  * 3. Select non-inverting output: set COM0A1, clear COM0A0.
  * 4. Choose prescaler = clk/1 by setting CS00 in TCCR0B.
- *    → PWM frequency = F_CPU / 256 (~31.3 kHz at 8 MHz)
+ *    → PWM frequency = F_CPU / 256 (62.5 kHz at 16 MHz)
  */
-void pwm_init(void) {
-  PWM_DDR |= (1 << PWM_PIN); /* PB0 as output */
+static void pwm_t0_init(void) {
+  PWM_DDR |= (1 << PWM_T0_PIN); /* PB0 as output */
 
   TCCR0A = (1 << WGM01) | (1 << WGM00) /* Fast PWM mode */
            | (1 << COM0A1);            /* Non-inverting on OC0A */
 
-  /* Use TCCR0B for prescaler: clk/1 → ~31.3 kHz PWM at 8 MHz */
+  /* Use TCCR0B for prescaler: clk/1 → 62.5 kHz PWM at 16 MHz */
   TCCR0B = (1 << CS00);
 }
 
 /**
- * Set PWM duty cycle.
+ * Set Timer0 duty cycle.
  * @param duty 0 → 0% (always low), 255 → ~100% (always high).
  */
-void pwm_set(uint8_t duty) { OCR0A = duty; }
+static void pwm_t0_set(uint8_t duty) { OCR0A = duty; }
 
 /**
- * Disable PWM and force the output pin low.
+ * Set Timer0 duty cycle from a 16-bit duty, rounded to the nearest 8-bit
+ * step.
+ *
+ * Timer0 is not dithered: its overflow comes every 256 CPU cycles, so a
+ * dither ISR would cost about 15% of the CPU and stretch every busy-wait
+ * delay by as much.
+ */
+static void pwm_t0_set16(uint16_t duty) {
+  pwm_t0_set(duty >= 0xFF80 ? 0xFF : (uint8_t)((duty + 0x80) >> 8));
+}
+
+/**
+ * Disable Timer0 PWM and force the output pin low.
  *
  * Steps:
  * 1. Disconnect OC0A by clearing COM0A1 and COM0A0.
  * 2. Drive PB0 low via PORT register.
  */
-void pwm_off(void) {
+static void pwm_t0_off(void) {
   TCCR0A &= ~((1 << COM0A1) | (1 << COM0A0)); /* Disconnect OC0A */
-  PWM_PORT &= ~(1 << PWM_PIN);                /* PB0 = 0 */
+  PWM_PORT &= ~(1 << PWM_T0_PIN);             /* PB0 = 0 */
+}
+
+#endif /* PWM_USE_TIMER0 */
+
+#if PWM_USE_TIMER1
+
+#if PWM_T1_TOP > 255
+#error "PWM_FREQUENCY too low for Timer1 at PCK/16 (OCR1C must fit 8 bits)"
+#endif
+
+static pwm_dither_t pwm_t1_dither;
+
+/**
+ * Initialize Timer1 for PWM on OC1B (PB4), clocked from the PLL.
+ *
+ * Steps:
+ * 1. Enable the PLL if it is not already running (it is when the system
+ *    clock is the PLL, FUSE_L = 0xF1), wait for lock, then select it as the
+ *    Timer1 clock source (PCKE).
+ * 2. Set OCR1C to TOP for exactly PWM_FREQUENCY.
+ * 3. Enable PWM mode on channel B: set PWM1B, non-inverting COM1B1.
+ * 4. Start Timer1 with prescaler = PCK/16 (CS12 | CS10).
+ */
+static void pwm_t1_init(void) {
+  PWM_PORT &= ~(1 << PWM_T1_PIN); /* PB4 low while OC1B is disconnected */
+  PWM_DDR |= (1 << PWM_T1_PIN);   /* PB4 as output */
+
+  if (!(PLLCSR & (1 << PLLE))) {
+    PLLCSR = (1 << PLLE); /* Start the PLL */
+    _delay_us(100);       /* Let the PLL settle before polling PLOCK */
+  }
+  while (!(PLLCSR & (1 << PLOCK)))
+    ;
+  PLLCSR |= (1 << PCKE); /* Asynchronous 64 MHz PCK for Timer1 */
+
+  OCR1C = PWM_T1_TOP; /* 4 MHz / (159 + 1) = 25 kHz */
+  OCR1B = 0;
+
+  GTCCR = (1 << PWM1B)     /* PWM mode on channel B, TOP = OCR1C */
+          | (1 << COM1B1); /* Non-inverting on OC1B */
+
+  /* Only the clock select bits: OC1A stays disconnected from the 1-Wire pin */
+  TCCR1 = (1 << CS12) | (1 << CS10); /* PCK/16 */
+}
+
+/**
+ * Set Timer1 duty cycle.
+ * @param duty 0 → 0% (pin held low), 255 → 100% (pin held high).
+ *
+ * Values in between are scaled from 0–255 onto 0–OCR1C.
+ */
+static void pwm_t1_set(uint8_t duty) {
+  TIMSK &= ~(1 << TOIE1); /* Stop dithering */
+
+  if (duty == 0 || duty == 255) {
+    GTCCR &= ~((1 << COM1B1) | (1 << COM1B0)); /* Disconnect OC1B */
+    if (duty)
+      PWM_PORT |= (1 << PWM_T1_PIN); /* PB4 = 1 */
+    else
+      PWM_PORT &= ~(1 << PWM_T1_PIN); /* PB4 = 0 */
+    return;
+  }
+
+  OCR1B = (uint8_t)(((uint16_t)duty * (PWM_T1_TOP + 1) + 128) >> 8);
+  GTCCR |= (1 << COM1B1); /* Reconnect OC1B */
+}
+
+/**
+ * Set Timer1 duty cycle with 16-bit resolution (see pwm_set16()).
+ */
+static void pwm_t1_set16(uint16_t duty) {
+  if (duty == 0 || duty == 0xFFFF) {
+    pwm_t1_set((uint8_t)(duty >> 8)); // Clean 0% / 100%, no dithering
+    return;
+  }
+
+  uint8_t base = pwm_dither_split(&pwm_t1_dither, duty, PWM_T1_TOP + 1);
+
+  if (!pwm_t1_dither.frac) {
+    TIMSK &= ~(1 << TOIE1); // Exact step: no dithering needed
+    OCR1B = base;
+    GTCCR |= (1 << COM1B1);
+  } else if (!(TIMSK & (1 << TOIE1))) {
+    OCR1B = base;
+    GTCCR |= (1 << COM1B1); // Reconnect after a static 0% / 100%
+    TIMSK |= (1 << TOIE1);  // Start dithering
+  }
+}
+
+/**
+ * Disable Timer1 PWM and force the output pin low.
+ *
+ * Steps:
+ * 1. Stop dithering and disconnect OC1B by clearing COM1B1 and COM1B0.
+ * 2. Drive PB4 low via PORT register.
+ */
+static void pwm_t1_off(void) {
+  TIMSK &= ~(1 << TOIE1);                    /* Stop dithering */
+  GTCCR &= ~((1 << COM1B1) | (1 << COM1B0)); /* Disconnect OC1B */
+  PWM_PORT &= ~(1 << PWM_T1_PIN);            /* PB4 = 0 */
+}
+
+/**
+ * Timer1 overflow: load the dithered compare value for the next period.
+ */
+ISR(TIMER1_OVF_vect) { OCR1B = pwm_dither_next(&pwm_t1_dither); }
+
+#endif /* PWM_USE_TIMER1 */
+
+// Channel 0 is the PWM_BACKEND timer, channel 1 the other one
+#if PWM_BACKEND == PWM_BACKEND_TIMER1
+#define pwm_ch0_init pwm_t1_init
+#define pwm_ch0_set pwm_t1_set
+#define pwm_ch0_set16 pwm_t1_set16
+#define pwm_ch0_off pwm_t1_off
+#define pwm_ch1_init pwm_t0_init
+#define pwm_ch1_set16 pwm_t0_set16
+#define pwm_ch1_off pwm_t0_off
+#else
+#define pwm_ch0_init pwm_t0_init
+#define pwm_ch0_set pwm_t0_set
+#define pwm_ch0_set16 pwm_t0_set16
+#define pwm_ch0_off pwm_t0_off
+#define pwm_ch1_init pwm_t1_init
+#define pwm_ch1_set16 pwm_t1_set16
+#define pwm_ch1_off pwm_t1_off
+#endif
+
+/**
+ * Initialize the timers and pins of all PWM channels.
+ */
+void pwm_init(void) {
+  pwm_ch0_init();
+#if PWM_CHANNELS > 1
+  pwm_ch1_init();
+#endif
+}
+
+/**
+ * Set channel 0 PWM duty cycle.
+ * @param duty 0 → 0%, 255 → 100% (~100% on Timer0).
+ */
+void pwm_set(uint8_t duty) { pwm_ch0_set(duty); }
+
+/**
+ * Set channel 0 PWM duty cycle with 16-bit resolution.
+ * @param duty 0 → 0%, 0xFFFF → 100%.
+ *
+ * The duty is split into an integer compare value and an 8-bit fraction.
+ * When the fraction is non-zero the timer overflow ISR applies first-order
+ * sigma-delta modulation, alternating between the compare value and the next
+ * step so that the average over 256 PWM periods matches the requested duty.
+ * The fan's inertia filters this into 8 extra bits of effective resolution
+ * (10–12 useful bits in practice, ~10 ms dither period at 25 kHz).
+ *
+ * Only Timer1 is dithered. Its ISR runs every 640 CPU cycles at 16 MHz and
+ * takes about 40 of them (~6% of the CPU, and _delay_us() / _delay_ms()
+ * outside critical sections run ~6% long). A Timer0 channel rounds the duty
+ * to 8 bits instead.
+ */
+void pwm_set16(uint16_t duty) { pwm_ch0_set16(duty); }
+
+/**
+ * Set the 16-bit duty cycle of one channel (see pwm_set16()).
+ * @param channel 0 to PWM_CHANNELS - 1; out of range selects channel 0.
+ */
+void pwm_channel_set16(uint8_t channel, uint16_t duty) {
+#if PWM_CHANNELS > 1
+  if (channel == 1) {
+    pwm_ch1_set16(duty);
+    return;
+  }
+#else
+  (void)channel;
+#endif
+  pwm_ch0_set16(duty);
+}
+
+/**
+ * Disable PWM on all channels and force their output pins low.
+ */
+void pwm_off(void) {
+  pwm_ch0_off();
+#if PWM_CHANNELS > 1
+  pwm_ch1_off();
+#endif
 }
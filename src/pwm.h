@@ -28,28 +28,73 @@
 #define TINY85FANCONTROL_SRC_PWM_H_
 
 /**
- * PWM driver for ATtiny85 using Timer0 channel A (OC0A on PB0).
+ * PWM driver for ATtiny85 with up to two independent output channels.
  *
+ * Timer0 channel A (OC0A on PB0)
  * - Uses 8-bit Fast PWM (Mode 3):
  *     • WGM01=1, WGM00=1 → Fast PWM with TOP=0xFF
  *     • COM0A1=1, COM0A0=0 → Non-inverting output: OC0A clears on compare match, sets at BOTTOM
- * - Default prescaler = clk/1 → PWM frequency = F_CPU / 256
- *   (~31.3 kHz at 8 MHz CPU clock)
+ * - Prescaler = clk/1 → PWM frequency = F_CPU / 256
+ *   (62.5 kHz at 16 MHz CPU clock)
+ *
+ * Timer1 channel B (OC1B on PB4)
+ * - Clocked from the 64 MHz PLL (PCK), prescaler = PCK/16 → 4 MHz
+ * - OCR1C sets TOP so that PWM frequency = 4 MHz / (OCR1C + 1)
+ *   (exactly 25 kHz with OCR1C = 159, inside the 4-pin fan spec of 21–28 kHz)
+ * - Duty 0 and 255 disconnect OC1B and drive the pin statically, giving a
+ *   clean 0% and 100% without the narrow compare-match spikes.
+ *
+ * OC0B and OC1A both share PB1 with the 1-Wire bus, so at most two channels
+ * are available. PWM_BACKEND (see Makefile) selects the timer for channel 0;
+ * with PWM_CHANNELS = 2 the other timer drives channel 1.
  *
  * Functions:
- *  • pwm_init():  Configure Timer0 and PB0 for PWM output
- *  • pwm_set(d): Set duty cycle (0–255)
- *  • pwm_off():  Disable PWM and drive PB0 low
+ *  • pwm_init():  Configure the timers and pins for PWM output
+ *  • pwm_set(d): Set channel 0 duty cycle (0–255)
+ *  • pwm_set16(d): Set channel 0 duty cycle (0–65535); on Timer1 sigma-delta
+ *                  dithered between compare steps by the overflow ISR, on
+ *                  Timer0 rounded to 8 bits
+ *  • pwm_channel_set16(c, d): Same as pwm_set16() for channel c
+ *  • pwm_off():  Disable PWM and drive all channel pins low
  */
 
 #include <stdint.h>
 
-#define PWM_DDR   DDRB    /* Data Direction Register for PWM pin */
-#define PWM_PORT  PORTB   /* Port register for PWM pin */
-#define PWM_PIN   PB0     /* Pin number for OC0A (PB0) */
+#define PWM_BACKEND_TIMER0 0
+#define PWM_BACKEND_TIMER1 1
+
+#ifndef PWM_BACKEND
+#define PWM_BACKEND PWM_BACKEND_TIMER0
+#endif
+
+#ifndef PWM_CHANNELS
+#define PWM_CHANNELS 1
+#endif
+
+#if PWM_CHANNELS < 1 || PWM_CHANNELS > 2
+#error "PWM_CHANNELS must be 1 or 2 (OC0B/OC1A share PB1 with 1-Wire)"
+#endif
+
+#define PWM_DDR   DDRB    /* Data Direction Register for PWM pins */
+#define PWM_PORT  PORTB   /* Port register for PWM pins */
+#define PWM_T0_PIN PB0    /* Pin number for OC0A (PB0) */
+#define PWM_T1_PIN PB4    /* Pin number for OC1B (PB4) */
+
+#define PWM_PLL_CLOCK     (64000000UL) /* PCK frequency from the PLL */
+#define PWM_T1_PRESCALER  (16UL)       /* PCK/16 → 4 MHz timer clock */
+#define PWM_FREQUENCY     (25000UL)    /* Timer1 PWM frequency (Hz) */
+#define PWM_T1_TOP        (PWM_PLL_CLOCK / PWM_T1_PRESCALER / PWM_FREQUENCY - 1)
+
+#if PWM_BACKEND == PWM_BACKEND_TIMER1
+#define PWM_PIN   PWM_T1_PIN /* Channel 0 pin */
+#else
+#define PWM_PIN   PWM_T0_PIN /* Channel 0 pin */
+#endif
 
 void pwm_init(void);
 void pwm_set(uint8_t duty);
+void pwm_set16(uint16_t duty);
+void pwm_channel_set16(uint8_t channel, uint16_t duty);
 void pwm_off(void);
 
 #endif /* TINY85FANCONTROL_SRC_PWM_H_ */
\ No newline at end of file
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_SENSOR_H_
+#define TINY85FANCONTROL_SRC_SENSOR_H_
+
+/**
+ * External temperature sensor interface, resolved at compile time.
+ *
+ * SENSOR (see Makefile) selects the driver behind these inline functions,
+ * so the control loop calls the driver directly with no function pointers.
+ * All drivers report temperatures in 1/16 °C and SENSOR_ERROR on failure.
+ *
+ *  • SENSOR_DS18B20: DS18B20 on the 1-Wire bus (PB1), ~750 ms conversion
+ *  • SENSOR_TMP102:  TMP102 / LM75 on the USI I2C bus (PB0/PB2), no wait
+ *
+ * SENSOR_INTERVAL_MS is the wait between control passes that suits the
+ * driver: the tach gate time, and the time base of everything counted in
+ * passes (filter, feed-forward history, stats flush).
+ *
+ * Functions:
+ *  • sensor_scan():             find the sensors, returns the count
+ *  • sensor_count():            sensors found by the last scan
+ *  • sensor_start_conversion(): start converting on all sensors
+ *  • sensor_wait_conversion():  wait for the conversion to finish
+ *  • sensor_read_raw(n):        last temperature of sensor n
+ *
+ * With SENSOR_ALARMS (DS18B20_ALARM_MODE), also:
+ *  • sensor_alarms():            sensors that left their window, as a mask
+ *  • sensor_set_alarm(n, lo, hi): window of sensor n, lo < T < hi in °C
+ */
+
+#include <stdint.h>
+
+#define SENSOR_DS18B20 0
+#define SENSOR_TMP102 1
+
+#ifndef SENSOR
+#define SENSOR SENSOR_DS18B20
+#endif
+
+#if SENSOR == SENSOR_TMP102
+
+#include "tmp102.h"
+
+#define SENSOR_ERROR TMP102_ERROR
+#define SENSOR_MAX_SENSORS TMP102_MAX_SENSORS
+#define SENSOR_ALARMS 0
+
+// Converts continuously at 4 Hz: a fresh reading every pass at 1 s, with a
+// tach gate still long enough for 30 RPM resolution
+#ifndef SENSOR_INTERVAL_MS
+#define SENSOR_INTERVAL_MS (1000)
+#endif
+
+static inline uint8_t sensor_scan(void) { return tmp102_scan(); }
+static inline uint8_t sensor_count(void) { return tmp102_count(); }
+static inline uint8_t sensor_start_conversion(void) { return 1; }
+static inline void sensor_wait_conversion(void) {}
+static inline int16_t sensor_read_raw(uint8_t index) {
+  return tmp102_read_sensor_raw(index);
+}
+
+#else /* SENSOR_DS18B20 */
+
+#include "ds18b20.h"
+
+#define SENSOR_ERROR DS18B20_ERROR
+#define SENSOR_MAX_SENSORS DS18B20_MAX_SENSORS
+#define SENSOR_ALARMS DS18B20_ALARM_MODE
+
+// Conversion cadence: the 750 ms conversion overlaps the wait
+#ifndef SENSOR_INTERVAL_MS
+#define SENSOR_INTERVAL_MS (2750)
+#endif
+
+static inline uint8_t sensor_scan(void) { return ds18b20_scan(); }
+static inline uint8_t sensor_count(void) { return ds18b20_count(); }
+static inline uint8_t sensor_start_conversion(void) {
+  return ds18b20_start_conversion();
+}
+static inline void sensor_wait_conversion(void) { ds18b20_wait_conversion(); }
+static inline int16_t sensor_read_raw(uint8_t index) {
+  return ds18b20_read_sensor_raw(index);
+}
+#if SENSOR_ALARMS
+static inline uint8_t sensor_alarms(void) { return ds18b20_alarm_search(); }
+static inline void sensor_set_alarm(uint8_t index, int8_t low, int8_t high) {
+  ds18b20_set_alarm(index, low, high);
+}
+#endif
+
+#endif /* SENSOR */
+
+/**
+ * Convert a raw reading (1/16 °C per bit) to whole °C, rounding up.
+ */
+static inline int16_t sensor_raw_to_celsius(int16_t raw) {
+  return (raw + 0x0F) >> 4;
+}
+
+#endif /* TINY85FANCONTROL_SRC_SENSOR_H_ */
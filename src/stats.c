@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "stats.h"
+#include "crc8.h"
+#include "sensor.h"
+#include "uart.h"
+
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stddef.h>
+
+#define STATS_RECORD_SIZE (sizeof(stats_record_t))
+#define STATS_CRC_LEN (offsetof(stats_record_t, crc))
+#define STATS_CRC_INIT (0x5A) // Non-zero: an all-zero slot does not check
+#define STATS_SEQ_POS (STATS_CRC_LEN - 1) // Flush step that writes seq
+#define STATS_FLUSH_STEPS (STATS_CRC_LEN + 2) // Invalidate, body, CRC
+#define STATS_SAMPLES_MAX (1UL << 23) // Halve sum and count beyond this
+
+_Static_assert(STATS_RECORD_SIZE * STATS_EEPROM_SLOTS <= E2END + 1,
+               "STATS_EEPROM_SLOTS records do not fit in EEPROM");
+_Static_assert(STATS_FLUSH_STEPS < 255, "stats_flush_pos is 8 bits");
+_Static_assert(offsetof(stats_record_t, seq) == 0, "seq is written last");
+_Static_assert(offsetof(stats_record_t, samples) ==
+                   offsetof(stats_record_t, temp_sum) + sizeof(int32_t),
+               "temp_sum and samples are flushed as one chunk");
+
+static stats_record_t stats; // Live statistics
+static uint8_t stats_flush_pos = STATS_FLUSH_STEPS; // Next step, idle at end
+static uint8_t stats_flush_crc;     // CRC of the bytes written so far
+static uint8_t stats_flush_buf[8];  // Chunk being written, right-aligned
+static uint8_t stats_flush_end;     // Record offset where the chunk ends
+static uint8_t stats_slot = STATS_EEPROM_SLOTS - 1; // Slot of latest record
+static uint16_t stats_passes = 0; // Samples since the last flush
+
+/**
+ * @return EEPROM address of a ring slot
+ */
+static uint8_t *stats_slot_addr(uint8_t slot) {
+  return (uint8_t *)(uintptr_t)(slot * STATS_RECORD_SIZE);
+}
+
+/**
+ * Reset the live statistics to an empty record.
+ */
+static void stats_clear(void) {
+  uint8_t *p = (uint8_t *)&stats;
+  for (uint8_t i = 0; i < STATS_RECORD_SIZE; i++) {
+    p[i] = 0;
+  }
+  stats.temp_min = INT16_MAX;
+  stats.temp_max = INT16_MIN;
+}
+
+/**
+ * Load the newest valid record from the EEPROM ring, if any.
+ */
+void stats_init(void) {
+  uint8_t found = 0;
+  uint16_t newest = 0;
+
+  stats_clear();
+  stats_slot = STATS_EEPROM_SLOTS - 1; // Empty ring: first flush to slot 0
+  stats_flush_pos = STATS_FLUSH_STEPS; // No flush pending
+  stats_passes = 0;
+
+  // Check each slot in place, so no second record is needed in SRAM
+  for (uint8_t slot = 0; slot < STATS_EEPROM_SLOTS; slot++) {
+    const uint8_t *addr = stats_slot_addr(slot);
+    uint8_t crc = STATS_CRC_INIT;
+
+    for (uint8_t i = 0; i < STATS_CRC_LEN; i++) {
+      crc = crc8_update(crc, eeprom_read_byte(addr + i));
+    }
+    if (crc != eeprom_read_byte(addr + STATS_CRC_LEN)) {
+      continue; // Blank, or torn by a reset during a flush
+    }
+
+    // Newest by sequence number, modulo 2^16
+    uint16_t seq = eeprom_read_word((const uint16_t *)addr);
+    if (!found || (int16_t)(seq - newest) > 0) {
+      newest = seq;
+      stats_slot = slot;
+      found = 1;
+    }
+  }
+
+  if (found) {
+    eeprom_read_block(&stats, stats_slot_addr(stats_slot), STATS_RECORD_SIZE);
+  }
+}
+
+/**
+ * Write the next byte of a pending flush if the EEPROM is idle.
+ *
+ * Instead of a second copy of the record, each field is copied into
+ * stats_flush_buf when its first byte is due, so a multi-byte value is
+ * never written half old, half new. temp_sum and samples are one chunk as
+ * they are halved together.
+ *
+ * Order of the steps, so that a reset at any point leaves a slot that is
+ * either invalid or still the old, oldest record:
+ *  1. the slot's CRC byte is inverted, so the old CRC no longer checks;
+ *  2. the body after seq, in record order;
+ *  3. seq: until here a torn slot keeps its old (oldest) sequence number
+ *     and never wins as newest, even if its CRC matches by chance;
+ *  4. the CRC of the whole record. A reset between 3 and 4 is caught by
+ *     the inverted CRC (1 in 256 chance of a match).
+ */
+static void stats_flush_step(void) {
+  if (stats_flush_pos >= STATS_FLUSH_STEPS || !eeprom_is_ready()) {
+    return;
+  }
+
+  uint8_t step = stats_flush_pos;
+  uint8_t *slot = stats_slot_addr((stats_slot + 1) % STATS_EEPROM_SLOTS);
+  uint8_t pos;
+  uint8_t byte;
+
+  if (step == 0) {
+    pos = STATS_CRC_LEN;
+    byte = (uint8_t)~eeprom_read_byte(slot + pos);
+  } else if (step == STATS_FLUSH_STEPS - 1) {
+    pos = STATS_CRC_LEN;
+    byte = stats_flush_crc;
+  } else if (step >= STATS_SEQ_POS) {
+    pos = step - STATS_SEQ_POS; // seq does not change during a flush
+    byte = ((const uint8_t *)&stats.seq)[pos];
+  } else {
+    pos = step + sizeof(stats.seq) - 1;
+    if (pos >= stats_flush_end) {
+      // Start of a chunk: 2-byte field, or temp_sum and samples together
+      uint8_t len = (pos == offsetof(stats_record_t, temp_sum)) ? 8 : 2;
+      const uint8_t *src = (const uint8_t *)&stats + pos;
+      for (uint8_t i = 0; i < len; i++) {
+        stats_flush_buf[sizeof(stats_flush_buf) - len + i] = src[i]; // At end
+      }
+      stats_flush_end = pos + len;
+    }
+
+    byte = stats_flush_buf[sizeof(stats_flush_buf) - (stats_flush_end - pos)];
+    stats_flush_crc = crc8_update(stats_flush_crc, byte);
+  }
+
+  eeprom_update_byte(slot + pos, byte);
+
+  if (++stats_flush_pos == STATS_FLUSH_STEPS) {
+    stats_slot = (stats_slot + 1) % STATS_EEPROM_SLOTS; // Record now valid
+  }
+}
+
+/**
+ * Record one control pass.
+ *
+ * @param temp_q4 Zone temperature in 1/16 °C, SENSOR_ERROR if unknown
+ * @param duty PWM duty cycle (0-65535)
+ * @param errors Failed sensor reads in this pass
+ * @param stalled Non-zero if the fan was stalled
+ * @return 1 when a new flush to EEPROM was started
+ */
+uint8_t stats_sample(int16_t temp_q4, uint16_t duty, uint8_t errors,
+                     uint8_t stalled) {
+  uint8_t flushed = 0;
+
+  stats_flush_step();
+
+  if (stats.sensor_errors <= UINT16_MAX - errors)
+    stats.sensor_errors += errors;
+  if (stalled && stats.stalls != UINT16_MAX)
+    stats.stalls++;
+
+  if (temp_q4 != SENSOR_ERROR) {
+    if (temp_q4 < stats.temp_min)
+      stats.temp_min = temp_q4;
+    if (temp_q4 > stats.temp_max)
+      stats.temp_max = temp_q4;
+
+    int16_t celsius = sensor_raw_to_celsius(temp_q4);
+    stats.temp_sum += celsius;
+    if (++stats.samples >= STATS_SAMPLES_MAX) {
+      stats.temp_sum /= 2; // Keep the mean, make room for more samples
+      stats.samples /= 2;
+    }
+
+    // 8 °C bins from STATS_TEMP_BASE, first and last are open-ended
+    int16_t bin = (celsius - STATS_TEMP_BASE + 8) >> 3;
+    if (bin < 0)
+      bin = 0;
+    if (bin > STATS_TEMP_BINS - 1)
+      bin = STATS_TEMP_BINS - 1;
+
+    uint16_t *count = &stats.hist[bin][duty >> 14];
+    if (++*count == UINT16_MAX) {
+      // Halve all bins: keeps the shape, bounded to one pass of 32 bins
+      for (uint8_t t = 0; t < STATS_TEMP_BINS; t++) {
+        for (uint8_t d = 0; d < STATS_DUTY_BINS; d++) {
+          stats.hist[t][d] >>= 1;
+        }
+      }
+    }
+  }
+
+  if (++stats_passes >= STATS_FLUSH_INTERVAL &&
+      stats_flush_pos >= STATS_FLUSH_STEPS) {
+    stats_passes = 0;
+    stats.seq++;
+    // The CRC covers seq first, though it is written after the body
+    stats_flush_crc = STATS_CRC_INIT;
+    for (uint8_t i = 0; i < sizeof(stats.seq); i++) {
+      stats_flush_crc =
+          crc8_update(stats_flush_crc, ((const uint8_t *)&stats.seq)[i]);
+    }
+    stats_flush_end = 0;
+    stats_flush_pos = 0;
+    flushed = 1;
+  }
+
+  return flushed;
+}
+
+/**
+ * Print the statistics as a telemetry frame on the UART.
+ */
+void stats_report(void) {
+  uart_print_P(PSTR("Stats: samples="));
+  uart_print_udec32(stats.samples);
+  if (stats.samples) {
+    uart_print_P(PSTR(" min="));
+    uart_print_dec16(sensor_raw_to_celsius(stats.temp_min));
+    uart_print_P(PSTR(" max="));
+    uart_print_dec16(sensor_raw_to_celsius(stats.temp_max));
+    uart_print_P(PSTR(" mean="));
+    uart_print_dec16((int16_t)(stats.temp_sum / (int32_t)stats.samples));
+    uart_print_P(PSTR(" C"));
+  }
+  uart_print_P(PSTR(" errors="));
+  uart_print_udec32(stats.sensor_errors);
+  uart_print_P(PSTR(" stalls="));
+  uart_print_udec32(stats.stalls);
+  uart_print_P(PSTR("\r\n"));
+
+  // One group of duty quartiles per temperature bin
+  uart_print_P(PSTR("Hist:"));
+  for (uint8_t t = 0; t < STATS_TEMP_BINS; t++) {
+    uart_print(t ? " |" : "");
+    for (uint8_t d = 0; d < STATS_DUTY_BINS; d++) {
+      uart_print_P(PSTR(" "));
+      uart_print_udec32(stats.hist[t][d]);
+    }
+  }
+  uart_print_P(PSTR("\r\n"));
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_STATS_H_
+#define TINY85FANCONTROL_SRC_STATS_H_
+
+/**
+ * Lifetime statistics of zone 0, kept in SRAM and persisted to EEPROM.
+ *
+ * - Running min / max / mean temperature
+ * - Histogram of duty vs temperature: STATS_TEMP_BINS bins of 8 °C from
+ *   STATS_TEMP_BASE (outer bins open-ended) by STATS_DUTY_BINS duty bins
+ * - Sensor error and fan stall counts
+ *
+ * stats_sample() takes bounded, constant time. Every STATS_FLUSH_INTERVAL
+ * samples the record is written to the next slot of a ring of
+ * STATS_EEPROM_SLOTS in EEPROM, one byte per sample so the control loop
+ * never waits for the EEPROM. Each field is copied out when its turn comes,
+ * so SRAM holds one record plus an 8-byte chunk. Each slot carries a
+ * sequence number and a CRC. A flush first invalidates the slot's CRC and
+ * writes the sequence number and CRC last, so a reset mid-flush never
+ * leaves a torn record that loads as the newest. At boot the newest valid
+ * slot is loaded.
+ *
+ * Wear: with the defaults (5 slots, flush every ~1 h) each EEPROM cell is
+ * written at most ~1750 times a year, against 100k rated cycles.
+ */
+
+#include "sensor.h"
+
+#include <stdint.h>
+
+#define STATS_TEMP_BINS (8)
+#define STATS_DUTY_BINS (4)
+#define STATS_TEMP_BASE (16) // Lower edge of temperature bin 1 (°C)
+
+// Control passes between EEPROM flushes (~1 h, 1309 at 2.75 s per pass)
+#ifndef STATS_FLUSH_INTERVAL
+#define STATS_FLUSH_INTERVAL (3600000UL / SENSOR_INTERVAL_MS)
+#endif
+
+// Records in the EEPROM ring, from address 0
+#ifndef STATS_EEPROM_SLOTS
+#define STATS_EEPROM_SLOTS (5)
+#endif
+
+// Statistics record, as kept in SRAM and stored in EEPROM
+typedef struct {
+  uint16_t seq;           // Flush sequence number
+  int16_t temp_min;       // 1/16 °C
+  int16_t temp_max;       // 1/16 °C
+  int32_t temp_sum;       // Sum of samples in °C
+  uint32_t samples;       // Samples in temp_sum
+  uint16_t sensor_errors; // Failed sensor reads
+  uint16_t stalls;        // Passes with a stalled fan
+  uint16_t hist[STATS_TEMP_BINS][STATS_DUTY_BINS];
+  uint8_t crc;            // CRC8 of all bytes above
+} stats_record_t;
+
+void stats_init(void);
+uint8_t stats_sample(int16_t temp_q4, uint16_t duty, uint8_t errors,
+                     uint8_t stalled);
+void stats_report(void);
+
+#endif /* TINY85FANCONTROL_SRC_STATS_H_ */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "tach.h"
+#include "clock.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/delay.h>
+
+#define TACH_POLL_MS (10) // Spin-up polling interval
+
+static volatile uint16_t tach_count = 0;
+
+/**
+ * Configure PB3 as input with pull-up and enable its pin change interrupt.
+ */
+void tach_init(void) {
+  TACH_DDR &= ~(1 << TACH_BIT); // Input
+  TACH_PORT |= (1 << TACH_BIT); // Pull-up for the open-collector output
+
+  PCMSK |= (1 << PCINT3); // PB3 pin change
+  GIMSK |= (1 << PCIE);   // Enable pin change interrupts
+}
+
+/**
+ * @return Number of tach pulses since tach_init(), wraps at 65536
+ */
+uint16_t tach_pulses(void) {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = tach_count;
+  SREG = sreg;
+  return count;
+}
+
+/**
+ * Wait until the fan is confirmed turning, or TACH_SPINUP_TIMEOUT_MS.
+ *
+ * Interrupts must be enabled.
+ *
+ * @return 1 if TACH_SPINUP_PULSES were seen, 0 on timeout
+ */
+uint8_t tach_wait_spinup(void) {
+  uint16_t start = tach_pulses();
+
+  for (uint16_t ms = 0; ms < TACH_SPINUP_TIMEOUT_MS; ms += TACH_POLL_MS) {
+    if ((uint16_t)(tach_pulses() - start) >= TACH_SPINUP_PULSES) {
+      return 1;
+    }
+    _delay_ms(TACH_POLL_MS);
+  }
+
+  return 0;
+}
+
+/**
+ * Check for a stalled fan, once per control pass.
+ *
+ * A fan is stalled when it is driven but gave no pulse since the previous
+ * call. Fans without a tach line never report a stall: the check only
+ * starts once the first pulse has been seen.
+ *
+ * @param driven Non-zero if the fan is currently driven (duty > 0)
+ * @return 1 if the fan is stalled, 0 otherwise
+ */
+uint8_t tach_stalled(uint8_t driven) {
+  static uint16_t last = 0;
+  uint16_t count = tach_pulses();
+  uint8_t stalled = driven && count != 0 && count == last;
+
+  last = count;
+  return stalled;
+}
+
+/**
+ * Measure the fan speed by counting pulses over a gate time.
+ *
+ * Blocks for gate_ms, so it doubles as the delay between control passes,
+ * and may run at scaled system clock (see clock_delay_ms()). Resolution is
+ * 60000 / (TACH_PULSES_PER_REV * gate_ms) RPM, 11 RPM for a 2.75 s gate
+ * (DS18B20), 30 RPM for 1 s (TMP102).
+ * Interrupts must be enabled.
+ *
+ * @param gate_ms Gate time in milliseconds, non-zero
+ * @return Fan speed in RPM, 0 for a stopped fan or no tach
+ */
+uint16_t tach_measure_rpm(uint16_t gate_ms) {
+  uint16_t start = tach_pulses();
+
+  clock_delay_ms(gate_ms);
+
+  uint32_t pulses = (uint16_t)(tach_pulses() - start);
+  uint32_t rpm = pulses * (60000UL / TACH_PULSES_PER_REV) / gate_ms;
+
+  return (rpm > 0xFFFF) ? 0xFFFF : (uint16_t)rpm;
+}
+
+/**
+ * Pin change on PB3: count falling edges only.
+ */
+ISR(PCINT0_vect) {
+  if (!(TACH_PIN & (1 << TACH_BIT))) {
+    tach_count++;
+  }
+}
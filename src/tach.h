@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_TACH_H_
+#define TINY85FANCONTROL_SRC_TACH_H_
+
+/**
+ * Fan tachometer input on PB3 (PCINT3).
+ *
+ * The open-collector tach output of the fan is pulled up by the internal
+ * pull-up and every falling edge is counted in the pin change interrupt.
+ * Most fans give 2 pulses per revolution. With no tach wired the pin idles
+ * high and no pulses are counted.
+ */
+
+#include <stdint.h>
+
+#define TACH_DDR DDRB
+#define TACH_PORT PORTB
+#define TACH_PIN PINB
+#define TACH_BIT PB3
+
+// Pulses that confirm the fan is turning during spin-up
+#ifndef TACH_SPINUP_PULSES
+#define TACH_SPINUP_PULSES (4)
+#endif
+
+// Longest spin-up kick when no pulses are seen (fans without tach)
+#ifndef TACH_SPINUP_TIMEOUT_MS
+#define TACH_SPINUP_TIMEOUT_MS (3000)
+#endif
+
+// Tach pulses per fan revolution (2 for standard PC fans)
+#ifndef TACH_PULSES_PER_REV
+#define TACH_PULSES_PER_REV (2)
+#endif
+
+void tach_init(void);
+uint16_t tach_pulses(void);
+uint8_t tach_wait_spinup(void);
+uint8_t tach_stalled(uint8_t driven);
+uint16_t tach_measure_rpm(uint16_t gate_ms);
+
+#endif /* TINY85FANCONTROL_SRC_TACH_H_ */
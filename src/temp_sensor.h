@@ -33,4 +33,4 @@ void temp_sensor_init(void);
 uint16_t temp_sensor_read_raw(void);
 int16_t temp_sensor_read_celsius(void);
 
-#endif // TINY85_FAN_CONTROL_SRC_UART_H_
+#endif // TINY85_FAN_CONTROL_SRC_TEMP_SENSOR_H_
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "tmp102.h"
+#include "i2c.h"
+
+#define TMP102_REG_TEMPERATURE (0x00)
+
+// 7-bit addresses of the sensors found by tmp102_scan()
+static uint8_t tmp102_addresses[TMP102_MAX_SENSORS];
+static uint8_t tmp102_sensor_count = 0;
+
+/**
+ * Probe the sensor addresses and point each sensor that answers at its
+ * temperature register, so later reads need no register write.
+ *
+ * @return number of sensors found
+ */
+uint8_t tmp102_scan(void) {
+  i2c_init();
+  tmp102_sensor_count = 0;
+
+  for (uint8_t i = 0; i < TMP102_MAX_SENSORS; i++) {
+    uint8_t address = TMP102_BASE_ADDRESS + i;
+
+    uint8_t found = i2c_start((uint8_t)(address << 1) | I2C_WRITE) &&
+                    i2c_write(TMP102_REG_TEMPERATURE);
+    i2c_stop();
+
+    if (found) {
+      tmp102_addresses[tmp102_sensor_count++] = address;
+    }
+  }
+
+  return tmp102_sensor_count;
+}
+
+/**
+ * @return number of sensors found by the last tmp102_scan()
+ */
+uint8_t tmp102_count(void) { return tmp102_sensor_count; }
+
+/**
+ * Read the last converted temperature of one sensor.
+ *
+ * @param index  sensor number, 0 to tmp102_count() - 1
+ * @return       raw temperature (1/16 °C), TMP102_ERROR on failure
+ */
+int16_t tmp102_read_sensor_raw(uint8_t index) {
+  if (index >= tmp102_sensor_count) {
+    return TMP102_ERROR;
+  }
+
+  uint8_t address = tmp102_addresses[index];
+  if (!i2c_start((uint8_t)(address << 1) | I2C_READ)) {
+    i2c_stop();
+    return TMP102_ERROR; // No acknowledge
+  }
+
+  uint8_t hi = i2c_read(1); // High byte, acknowledge
+  uint8_t lo = i2c_read(0); // Low byte, last
+  i2c_stop();
+
+  if (i2c_error()) {
+    return TMP102_ERROR; // SCL stuck low, bytes not valid
+  }
+
+  // Left-justified 12 bits: shift down to 1/16 °C per bit
+  return ((int16_t)((hi << 8) | lo)) >> 4;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_SRC_TMP102_H_
+#define TINY85FANCONTROL_SRC_TMP102_H_
+
+/**
+ * TMP102 / LM75 temperature sensors on the USI I2C bus.
+ *
+ * Both convert continuously and keep the last result in the temperature
+ * register, left-justified in two bytes (12 bits on the TMP102, 9–11 on
+ * LM75 variants). A read is one I2C transaction of ~50 us at 400 kHz, so
+ * there is no conversion to wait for.
+ */
+
+#include <stdint.h>
+
+// Error reading temperature, -273°C in 1/16 °C units (as DS18B20_ERROR)
+#define TMP102_ERROR (-(273 << 4))
+
+#define TMP102_BASE_ADDRESS (0x48) // A2..A0 / ADD0 select 0x48 + n
+
+// Addresses probed by tmp102_scan(), from TMP102_BASE_ADDRESS
+#ifndef TMP102_MAX_SENSORS
+#define TMP102_MAX_SENSORS (4)
+#endif
+
+uint8_t tmp102_scan(void);
+uint8_t tmp102_count(void);
+int16_t tmp102_read_sensor_raw(uint8_t index);
+
+#endif /* TINY85FANCONTROL_SRC_TMP102_H_ */
@@ -25,13 +25,23 @@
  */
 
 #include "uart.h"
+#include "profile.h"
+
+#if UART_ENABLE
 
 #include <avr/interrupt.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 
 static volatile uint8_t UART_INIT = 0;
 
+// Powers of ten for uart_print_dec16() and uart_print_udec32(), in flash
+static const uint16_t uart_powers16[] PROGMEM = {10000, 1000, 100, 10};
+static const uint32_t uart_powers32[] PROGMEM = {
+    1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL,
+    10000UL,      1000UL,      100UL,      10UL};
+
 // Local function prototypes
 static void uart_send_byte(uint8_t c);
 
@@ -67,41 +77,98 @@ void uart_print(const char *s) {
 }
 
 /**
- * @brief Print a signed 16-bit decimal number to the UART
+ * @brief Print a string stored in flash (PROGMEM / PSTR()) to the UART
  *
- * @param num A signed 16-bit integer to print
+ * @param s String to print, a flash address
  */
-void uart_print_dec16(int16_t num) {
-  int i = 8;       // Number of digits to print
-  char negate = 0; // Flag for negative numbers
-  char buffer[7];  // Buffer to hold digits and newline
-  char *ptr = buffer + sizeof(buffer) - 1;
+void uart_print_P(const char *s) {
+  if (!s) {
+    return;
+  }
 
-  *ptr-- = '\0'; // Null-terminate string
+  if (!UART_INIT) {
+    uart_init();
+  }
 
-  if (num == 0) {
-    *ptr-- = '0'; // Special case for zero
-    goto end;          // Skip further processing
+  char c;
+  while ((c = (char)pgm_read_byte(s))) {
+    uart_send_byte((uint8_t)c);
+    s++;
   }
+}
+
+/**
+ * @brief Print a signed 16-bit decimal number to the UART
+ *
+ * Digits are found by repeated subtraction of powers of ten, which is much
+ * cheaper on the AVR than a software division per digit. The magnitude is
+ * taken as unsigned so that -32768 prints correctly.
+ *
+ * @param num A signed 16-bit integer to print
+ */
+void uart_print_dec16(int16_t num) {
+  char buffer[7]; // Sign, 5 digits and terminator
+  char *ptr = buffer;
+  uint16_t value = (uint16_t)num;
+  uint8_t leading = 1; // Still skipping leading zeros
 
   if (num < 0) {
-    negate = 1; // Set flag for negative numbers
-    num = -num; // Make it positive for printing
+    *ptr++ = '-';              // Add minus sign for negative numbers
+    value = (uint16_t)-value; // Magnitude, 32768 fits in 16 bits
   }
 
-  while (num > 0 && i >= 0) {
-    *ptr-- = (num % 10) + '0'; // Convert digit to character
-    num /= 10;
+  for (uint8_t i = 0; i < sizeof(uart_powers16) / sizeof(uart_powers16[0]);
+       i++) {
+    uint16_t power = pgm_read_word(&uart_powers16[i]);
+    char digit = '0';
+    while (value >= power) {
+      value -= power;
+      digit++;
+    }
+
+    if (digit != '0' || !leading) {
+      *ptr++ = digit;
+      leading = 0;
+    }
   }
 
-  if (negate && i >= 0) {
-    *ptr-- = '-'; // Add minus sign for negative numbers
+  *ptr++ = (char)('0' + value); // Units, also prints a single 0
+  *ptr = '\0';                  // Null-terminate string
+
+  uart_print(buffer); // Print the buffer
+}
+
+/**
+ * @brief Print an unsigned 32-bit decimal number to the UART
+ *
+ * Same digit extraction as uart_print_dec16(), for counters.
+ *
+ * @param num An unsigned 32-bit integer to print
+ */
+void uart_print_udec32(uint32_t num) {
+  char buffer[11]; // 10 digits and terminator
+  char *ptr = buffer;
+  uint8_t leading = 1; // Still skipping leading zeros
+
+  for (uint8_t i = 0; i < sizeof(uart_powers32) / sizeof(uart_powers32[0]);
+       i++) {
+    uint32_t power = pgm_read_dword(&uart_powers32[i]);
+    char digit = '0';
+    while (num >= power) {
+      num -= power;
+      digit++;
+    }
+
+    if (digit != '0' || !leading) {
+      *ptr++ = digit;
+      leading = 0;
+    }
   }
 
-end:
+  *ptr++ = (char)('0' + num); // Units, also prints a single 0
+  *ptr = '\0';                // Null-terminate string
 
-  ++ptr; // Adjust to point to the first character
-  uart_print(ptr); // Print the buffer
+  uart_print(buffer);
 }
 
 /**
@@ -124,6 +191,7 @@ static inline void uart_tx_bit(_Bool b) {
  */
 static void uart_send_byte(uint8_t c) {
   cli();          // Stop interrupts to keep timing accurate
+  profile_irq_off();
   uart_tx_bit(0); // start bit
   // Send 8 bits, LSB first
   uart_tx_bit(c & 0b00000001); // BIT 0
@@ -135,5 +203,8 @@ static void uart_send_byte(uint8_t c) {
   uart_tx_bit(c & 0b01000000); // BIT 6
   uart_tx_bit(c & 0b10000000); // BIT 7
   uart_tx_bit(1);              // stop bit
+  profile_irq_on();
   sei();                       // Re-enable interrupts
-}
\ No newline at end of file
+}
+
+#endif /* UART_ENABLE */
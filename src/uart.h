@@ -35,16 +35,32 @@
 #define UART_BAUD_RATE (9600UL)
 #define UART_BIT_TIME (1000000UL / UART_BAUD_RATE)
 
-/** PIN for Tx **/
+/** PIN for Tx (PB1 when PB2 is taken by the USI I2C bus) **/
+#ifndef UART_TX_PIN
 #define UART_TX_PIN PB2
+#endif
 #define UART_TX_PORT PORTB
 #define UART_TX_DDR DDRB
 
 
+// 0 drops all UART output, e.g. when every pin is taken (I2C slave build)
+#ifndef UART_ENABLE
+#define UART_ENABLE 1
+#endif
+
 // API Functions
+#if UART_ENABLE
 void uart_init(void);
 void uart_print(const char *s);
+void uart_print_P(const char *s);
 void uart_print_dec16(int16_t num);
-int16_t temp_sensor_read_celsius(void);
+void uart_print_udec32(uint32_t num);
+#else
+static inline void uart_init(void) {}
+static inline void uart_print(const char *s) { (void)s; }
+static inline void uart_print_P(const char *s) { (void)s; }
+static inline void uart_print_dec16(int16_t num) { (void)num; }
+static inline void uart_print_udec32(uint32_t num) { (void)num; }
+#endif
 
 #endif /* TINY85FANCONTROL_SRC_UART_H_ */
\ No newline at end of file
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_TESTS_INCLUDE_AVR_INTERRUPT_H_
+#define TINY85FANCONTROL_TESTS_INCLUDE_AVR_INTERRUPT_H_
+
+/**
+ * Host stand-in for <avr/interrupt.h>: an ISR is a plain function that a
+ * test calls to simulate the interrupt, cli() / sei() track the I bit.
+ */
+
+#include <avr/io.h>
+
+#define ISR(vector, ...)                                                       \
+  void vector(void);                                                           \
+  void vector(void)
+
+#define cli() (SREG &= (uint8_t)~0x80)
+#define sei() (SREG |= 0x80)
+
+#endif /* TINY85FANCONTROL_TESTS_INCLUDE_AVR_INTERRUPT_H_ */
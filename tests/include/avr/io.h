@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef TINY85FANCONTROL_TESTS_INCLUDE_AVR_IO_H_
+#define TINY85FANCONTROL_TESTS_INCLUDE_AVR_IO_H_
+
+/**
+ * Host stand-in for <avr/io.h>: the ATtiny85 I/O registers used by the
+ * firmware, as plain variables (defined in tests/avr_stub.c) that tests can
+ * set and inspect. Bit numbers match the ATtiny85 datasheet.
+ */
+
+#include <stdint.h>
+
+extern volatile uint8_t SREG;
+extern volatile uint8_t DDRB, PORTB, PINB;
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B;
+extern volatile uint8_t TCCR1, GTCCR, TCNT1, OCR1A, OCR1B, OCR1C;
+extern volatile uint8_t TIMSK, TIFR, PLLCSR;
+extern volatile uint8_t USICR, USISR, USIDR, USIBR;
+extern volatile uint8_t GIMSK, PCMSK;
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+
+// USICR
+#define USISIE 7
+#define USIOIE 6
+#define USIWM1 5
+#define USIWM0 4
+#define USICS1 3
+#define USICS0 2
+#define USICLK 1
+#define USITC 0
+
+// USISR
+#define USISIF 7
+#define USIOIF 6
+#define USIPF 5
+#define USIDC 4
+#define USICNT3 3
+#define USICNT2 2
+#define USICNT1 1
+#define USICNT0 0
+
+// TIMSK / TIFR
+#define OCIE1A 6
+#define OCIE1B 5
+#define OCIE0A 4
+#define OCIE0B 3
+#define TOIE1 2
+#define TOIE0 1
+#define OCF1A 6
+#define OCF1B 5
+#define OCF0A 4
+#define OCF0B 3
+#define TOV1 2
+#define TOV0 1
+
+#define E2END 0x1FF // Last EEPROM address
+
+#define _BV(bit) (1 << (bit))
+
+#endif /* TINY85FANCONTROL_TESTS_INCLUDE_AVR_IO_H_ */
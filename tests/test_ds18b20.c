@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Host test of the DS18B20 fast read path (DS18B20_FAST_READ).
+ *
+ * src/ds18b20.c is linked against the fake onewire_* functions below,
+ * which play one sensor on the bus: they answer READ SCRATCHPAD from a
+ * scripted scratchpad and count the bytes the driver reads, so the tests
+ * can tell a 2-byte fast read from a 9-byte full one. The tests cover the
+ * fast / full read pattern, corruption caught by the CRC of a full read,
+ * and the full-read fallback for the 85 °C power-on value, an all-ones bus
+ * and a step that is too large.
+ *
+ * Build and run with `make test`.
+ */
+
+#include "crc8.h"
+#include "ds18b20.h"
+#include "onewire.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+#if DS18B20_FAST_READ != 4
+#error "Built with DS18B20_FAST_READ=4 by the Makefile"
+#endif
+
+// ---- Fake 1-Wire bus with one sensor ----
+
+static uint8_t bus_scratchpad[9]; // What the sensor holds
+static uint8_t bus_all_ones;      // Sensor gone: every read slot is 1
+static int8_t bus_flip = -1;      // Scratchpad byte corrupted on the wire
+static uint8_t bus_command;       // Last function command written
+static uint8_t bus_pos;           // Next scratchpad byte to send
+static unsigned bus_bytes_read;   // Scratchpad bytes read since reset
+
+uint8_t onewire_reset(void) {
+  bus_command = 0;
+  bus_pos = 0;
+  return ONEWIRE_LOW;
+}
+
+void onewire_write_byte(uint8_t data) {
+  if (data != ONEWIRE_CMD_SKIP_ROM) {
+    bus_command = data;
+  }
+}
+
+void onewire_write_bit(uint8_t bit) { (void)bit; }
+
+void onewire_write_block(const uint8_t *data, uint8_t len) {
+  (void)data;
+  (void)len;
+}
+
+uint8_t onewire_read_byte(void) {
+  if (bus_command != 0xBE || bus_pos >= sizeof(bus_scratchpad)) {
+    return 0xFF;
+  }
+  bus_bytes_read++;
+  uint8_t data = bus_all_ones ? 0xFF : bus_scratchpad[bus_pos];
+  if (bus_pos++ == bus_flip) {
+    data ^= 0x04;
+  }
+  return data;
+}
+
+void onewire_read_block(uint8_t *data, uint8_t len) {
+  for (uint8_t i = 0; i < len; i++) {
+    data[i] = onewire_read_byte();
+  }
+}
+
+uint8_t onewire_read_bit(void) { return 1; }
+
+bool onewire_read_bus(void) { return 1; }
+
+uint8_t onewire_search(onewire_search_t *state, uint8_t command,
+                       uint8_t rom[ONEWIRE_ROM_SIZE]) {
+  (void)state;
+  (void)command;
+  (void)rom;
+  return ONEWIRE_SEARCH_DONE;
+}
+
+/**
+ * Load a converted temperature into the sensor's scratchpad.
+ */
+static void bus_set(int16_t raw) {
+  bus_scratchpad[0] = (uint8_t)raw;
+  bus_scratchpad[1] = (uint8_t)((uint16_t)raw >> 8);
+  bus_scratchpad[2] = 0x4B; // TH
+  bus_scratchpad[3] = 0x46; // TL
+  bus_scratchpad[4] = 0x7F; // 12-bit
+  bus_scratchpad[5] = 0xFF;
+  bus_scratchpad[6] = 0x0C;
+  bus_scratchpad[7] = 0x10;
+  bus_scratchpad[8] = crc8(bus_scratchpad, 8);
+}
+
+/**
+ * Read sensor 0, counting the scratchpad bytes it took.
+ */
+static int16_t read_sensor(unsigned *bytes) {
+  bus_bytes_read = 0;
+  int16_t raw = ds18b20_read_sensor_raw(0);
+  *bytes = bus_bytes_read;
+  return raw;
+}
+
+// ---- Tests ----
+
+#define RAW(c) ((int16_t)((c) * 16))
+
+static void test_pattern(void) {
+  unsigned bytes;
+
+  // One full read, then DS18B20_FAST_READ - 1 fast ones, and again
+  for (uint8_t round = 0; round < 3; round++) {
+    for (uint8_t i = 0; i < DS18B20_FAST_READ; i++) {
+      int16_t want = RAW(25) + round * 4 + i;
+      bus_set(want);
+      int16_t raw = read_sensor(&bytes);
+      CHECK(raw == want, "round %u read %u: %d, want %d", round, i, raw, want);
+      CHECK(bytes == (i == 0 ? 9u : 2u), "round %u read %u: %u bytes", round,
+            i, bytes);
+    }
+  }
+}
+
+/**
+ * Run reads until the next one is a fast read.
+ */
+static void sync_to_fast(int16_t raw) {
+  unsigned bytes = 0;
+  bus_set(raw);
+  while (bytes != 9) {
+    read_sensor(&bytes);
+  }
+}
+
+static void test_crc(void) {
+  unsigned bytes;
+
+  // Corruption in a full read, in the temperature or elsewhere
+  for (int8_t flip = 0; flip < 9; flip++) {
+    sync_to_fast(RAW(25));
+    for (uint8_t i = 1; i < DS18B20_FAST_READ; i++) {
+      read_sensor(&bytes);
+    }
+    bus_flip = flip;
+    int16_t raw = read_sensor(&bytes);
+    bus_flip = -1;
+    CHECK(raw == DS18B20_ERROR, "flip in byte %d: %d accepted", flip, raw);
+    CHECK(bytes == 9, "flip in byte %d: %u bytes", flip, bytes);
+
+    // The failed read drops back to full reads
+    raw = read_sensor(&bytes);
+    CHECK(raw == RAW(25) && bytes == 9, "after flip: %d, %u bytes", raw, bytes);
+  }
+}
+
+static void test_fallback(void) {
+  unsigned bytes;
+
+  // Power-on value: confirmed by a full read, which has a good CRC
+  sync_to_fast(RAW(84));
+  bus_set(RAW(85));
+  int16_t raw = read_sensor(&bytes);
+  CHECK(raw == RAW(85) && bytes == 11, "85 C: %d, %u bytes", raw, bytes);
+
+  // All-ones bus (sensor gone): both reads fail, full read by CRC
+  sync_to_fast(RAW(25));
+  bus_all_ones = 1;
+  raw = read_sensor(&bytes);
+  CHECK(raw == DS18B20_ERROR && bytes == 11, "all ones: %d, %u bytes", raw,
+        bytes);
+  raw = read_sensor(&bytes);
+  CHECK(raw == DS18B20_ERROR && bytes == 9, "all ones again: %d, %u bytes",
+        raw, bytes);
+
+  bus_all_ones = 0;
+
+  // Near 0 °C all ones (-1/16 °C) is a small step: still a full read
+  sync_to_fast(RAW(0));
+  bus_all_ones = 1;
+  raw = read_sensor(&bytes);
+  CHECK(raw == DS18B20_ERROR && bytes == 11, "all ones at 0 C: %d, %u bytes",
+        raw, bytes);
+  bus_all_ones = 0;
+
+  // Step beyond DS18B20_FAST_MAX_STEP: confirmed by a full read
+  sync_to_fast(RAW(25));
+  bus_set(RAW(25) + DS18B20_FAST_MAX_STEP + 1);
+  raw = read_sensor(&bytes);
+  CHECK(raw == RAW(25) + DS18B20_FAST_MAX_STEP + 1 && bytes == 11,
+        "large step: %d, %u bytes", raw, bytes);
+
+  // A step within the limit stays fast
+  bus_set(RAW(25) + 2 * DS18B20_FAST_MAX_STEP + 1);
+  raw = read_sensor(&bytes);
+  CHECK(raw == RAW(25) + 2 * DS18B20_FAST_MAX_STEP + 1 && bytes == 2,
+        "small step: %d, %u bytes", raw, bytes);
+}
+
+int main(void) {
+  test_pattern();
+  test_crc();
+  test_fallback();
+
+  return test_report(__FILE__);
+}
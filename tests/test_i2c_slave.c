@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Host test of the I2C slave state machine (src/i2c_slave.c).
+ *
+ * A scripted master stands in for the USI: it puts each byte it shifts in
+ * USIDR and calls the counter overflow ISR, reads back what the slave
+ * loaded, and sees an ACK while the slave drives SDA with USIDR = 0. The
+ * tests cover register and block reads, a snapshot swap in the middle of a
+ * block read, override writes and their expiry, a NACKed address and a
+ * stuck start condition.
+ *
+ * Build and run with `make test`.
+ */
+
+#include "fan_curve.h"
+#include "i2c.h"
+#include "i2c_slave.h"
+#include "test_util.h"
+
+#include <avr/io.h>
+#include <stdio.h>
+
+void USI_START_vect(void);
+void USI_OVF_vect(void);
+
+// ---- Scripted master ----
+
+#define ADDRESS_WRITE ((I2C_SLAVE_ADDRESS << 1) | I2C_WRITE)
+#define ADDRESS_READ ((I2C_SLAVE_ADDRESS << 1) | I2C_READ)
+
+/**
+ * Counter overflow, if the slave has it enabled (not when idle).
+ */
+static void usi_overflow(void) {
+  if (USICR & (1 << USIOIE)) {
+    USI_OVF_vect();
+  }
+}
+
+/**
+ * @return 1 if the slave drives an ACK (SDA output, data bit 0)
+ */
+static uint8_t slave_acks(void) {
+  return (DDRB & (1 << I2C_SDA)) && !(USIDR & 0x80);
+}
+
+/**
+ * (Repeated) start: SDA then SCL pulled low by the master.
+ */
+static void master_start(void) {
+  PINB = 0;
+  USI_START_vect();
+}
+
+/**
+ * Send the address byte.
+ * @return 1 if the slave acknowledged
+ */
+static uint8_t master_address(uint8_t address) {
+  USIDR = address;
+  usi_overflow(); // 8 bits in
+  uint8_t ack = slave_acks();
+  if (ack) {
+    usi_overflow(); // ACK bit out: slave loads its first byte or waits
+  }
+  return ack;
+}
+
+/**
+ * Write one byte.
+ * @return 1 if the slave acknowledged
+ */
+static uint8_t master_write(uint8_t data) {
+  USIDR = data;
+  usi_overflow();
+  uint8_t ack = slave_acks();
+  if (ack) {
+    usi_overflow();
+  }
+  return ack;
+}
+
+/**
+ * Read one byte, then send ACK (more to come) or NACK (last byte).
+ */
+static uint8_t master_read(uint8_t ack) {
+  uint8_t data = USIDR; // Loaded by the slave at the previous overflow
+  CHECK(DDRB & (1 << I2C_SDA), "slave not driving SDA for data");
+  usi_overflow(); // 8 bits out: slave releases SDA for the (N)ACK
+  CHECK(!(DDRB & (1 << I2C_SDA)), "slave driving SDA during (N)ACK");
+  USIDR = ack ? 0x00 : 0x01; // Bit shifted in from SDA
+  usi_overflow();
+  return data;
+}
+
+/**
+ * Read `len` registers from `reg` in one transaction, with a repeated
+ * start. Calls `mid` (if set) after the first byte.
+ */
+static void master_read_block(uint8_t reg, uint8_t *data, uint8_t len,
+                              void (*mid)(void)) {
+  master_start();
+  CHECK(master_address(ADDRESS_WRITE), "write address NACKed");
+  CHECK(master_write(reg), "register pointer NACKed");
+  master_start();
+  CHECK(master_address(ADDRESS_READ), "read address NACKed");
+  for (uint8_t i = 0; i < len; i++) {
+    data[i] = master_read(i + 1 < len);
+    if (i == 0 && mid) {
+      mid();
+    }
+  }
+}
+
+static uint8_t master_read_register(uint8_t reg) {
+  uint8_t data;
+  master_read_block(reg, &data, 1, NULL);
+  return data;
+}
+
+// ---- Tests ----
+
+static void test_read_registers(void) {
+  i2c_slave_publish(0x0123, 0x4567, 0x89AB, I2C_SLAVE_STATUS_STALL);
+
+  CHECK(master_read_register(I2C_SLAVE_REG_ID) == I2C_SLAVE_ID, "ID");
+  CHECK(master_read_register(I2C_SLAVE_REG_STATUS) == I2C_SLAVE_STATUS_STALL,
+        "STATUS");
+  CHECK(master_read_register(I2C_SLAVE_REG_CURVE_COUNT) ==
+            fan_curve_default.count,
+        "CURVE_COUNT");
+  CHECK(master_read_register(I2C_SLAVE_REG_CURVE) ==
+            (uint8_t)fan_curve_default.points[0].temperature,
+        "first curve point temperature");
+  CHECK(master_read_register(I2C_SLAVE_REG_CURVE + 3) ==
+            fan_curve_default.points[1].pwm_duty,
+        "second curve point duty");
+  CHECK(master_read_register(0x0B) == 0xFF, "unused register");
+
+  uint8_t regs[8];
+  master_read_block(I2C_SLAVE_REG_ID, regs, sizeof(regs), NULL);
+  static const uint8_t want[8] = {I2C_SLAVE_ID, I2C_SLAVE_STATUS_STALL,
+                                  0x23,         0x01,
+                                  0x67,         0x45,
+                                  0xAB,         0x89};
+  for (uint8_t i = 0; i < sizeof(regs); i++) {
+    CHECK(regs[i] == want[i], "block read byte %u = %02x, want %02x", i,
+          regs[i], want[i]);
+  }
+}
+
+static void publish_new(void) { i2c_slave_publish(0x0FF0, 0, 0, 0); }
+
+static void test_snapshot_swap(void) {
+  uint8_t temp[2];
+
+  i2c_slave_publish(0x01FF, 0, 0, 0);
+
+  // The main loop publishes between the two bytes of TEMP: the transfer
+  // keeps the snapshot it started with
+  master_read_block(I2C_SLAVE_REG_TEMP, temp, 2, publish_new);
+  CHECK(temp[0] == 0xFF && temp[1] == 0x01, "torn read %02x %02x", temp[0],
+        temp[1]);
+
+  master_read_block(I2C_SLAVE_REG_TEMP, temp, 2, NULL);
+  CHECK(temp[0] == 0xF0 && temp[1] == 0x0F, "new snapshot %02x %02x",
+        temp[0], temp[1]);
+}
+
+static void test_override(void) {
+  uint16_t duty = 0;
+
+  CHECK(!i2c_slave_override(&duty), "override active before any write");
+
+  master_start();
+  CHECK(master_address(ADDRESS_WRITE), "write address NACKed");
+  CHECK(master_write(I2C_SLAVE_REG_OVERRIDE_CTRL), "pointer NACKed");
+  CHECK(master_write(1), "OVERRIDE_CTRL NACKed");
+  CHECK(master_write(0x80), "OVERRIDE_DUTY NACKed");
+
+  CHECK(master_read_register(I2C_SLAVE_REG_OVERRIDE_CTRL) == 1,
+        "OVERRIDE_CTRL readback");
+  CHECK(master_read_register(I2C_SLAVE_REG_OVERRIDE_DUTY) == 0x80,
+        "OVERRIDE_DUTY readback");
+
+  // Holds for I2C_SLAVE_OVERRIDE_PASSES passes without a refresh
+  for (uint8_t pass = 0; pass < I2C_SLAVE_OVERRIDE_PASSES; pass++) {
+    duty = 0;
+    CHECK(i2c_slave_override(&duty), "override dropped at pass %u", pass);
+    CHECK(duty == 0x8080, "forced duty %04x", duty);
+  }
+  CHECK(!i2c_slave_override(&duty), "override did not expire");
+  CHECK(master_read_register(I2C_SLAVE_REG_OVERRIDE_CTRL) == 0,
+        "OVERRIDE_CTRL still set after expiry");
+
+  // Read-only registers ignore writes
+  master_start();
+  CHECK(master_address(ADDRESS_WRITE), "write address NACKed");
+  CHECK(master_write(I2C_SLAVE_REG_ID), "pointer NACKed");
+  CHECK(master_write(0x00), "write to ID NACKed");
+  CHECK(master_read_register(I2C_SLAVE_REG_ID) == I2C_SLAVE_ID,
+        "ID overwritten");
+  CHECK(!i2c_slave_override(&duty), "write to ID started an override");
+}
+
+static void test_other_address(void) {
+  master_start();
+  CHECK(!master_address(((I2C_SLAVE_ADDRESS + 1) << 1) | I2C_READ),
+        "other address ACKed");
+  CHECK(!(DDRB & (1 << I2C_SDA)), "SDA not released");
+  CHECK(!(USICR & (1 << USIOIE)), "overflow interrupt still enabled");
+
+  // The next transaction for us still works
+  CHECK(master_read_register(I2C_SLAVE_REG_ID) == I2C_SLAVE_ID,
+        "ID after a foreign transaction");
+}
+
+static void test_stuck_start(void) {
+  PINB = (1 << I2C_SCL); // SCL high, SDA low: never completes
+  USI_START_vect();      // Must return
+  CHECK(!(USICR & (1 << USIOIE)), "stuck start left the slave active");
+
+  CHECK(master_read_register(I2C_SLAVE_REG_ID) == I2C_SLAVE_ID,
+        "ID after a stuck start");
+}
+
+int main(void) {
+  i2c_slave_init();
+
+  test_read_registers();
+  test_snapshot_swap();
+  test_override();
+  test_other_address();
+  test_stuck_start();
+
+  return test_report(__FILE__);
+}
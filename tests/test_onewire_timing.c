@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Cycle-level check of the 1-Wire slot timing in src/onewire.c.
+ *
+ * The asm block of onewire_rw_bits() is parsed from the source and run on
+ * a small AVR instruction model (datasheet cycle counts: sbi / cbi / sbiw
+ * 2, taken branch 2, skip of a one-word instruction 1, others 1), with
+ * the loop counts from the ONEWIRE_LOOPS_* macros the firmware is built
+ * with. It checks the slot times against the standard-speed limits, that
+ * interrupts are masked for the whole slot, and that a floating bus reads
+ * back what was written. At 16 MHz it also checks the exact times the
+ * macros are designed for: release 3.00 us, sample 12.88 us, write-0 low
+ * 61.12 us, recovery 3.06 us (48, 206, 978 and 49 cycles).
+ *
+ * Build and run with `make test` (from the repository root, or pass the
+ * path of onewire.c).
+ */
+
+#include "onewire.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---- Parsing ----
+
+#define MAX_INSNS (64)
+
+typedef struct {
+  char op[8];
+  char arg[48];
+} insn_t;
+
+static insn_t prog[MAX_INSNS];
+static int prog_len;
+static int labels[10]; // Instruction index of numeric labels 1: to 9:
+
+// Loop count operands: asm name -> macro in the operand list -> value
+static const struct {
+  const char *macro;
+  unsigned long value;
+} loop_macros[] = {
+    {"ONEWIRE_LOOPS_LOW", ONEWIRE_LOOPS_LOW},
+    {"ONEWIRE_LOOPS_SAMPLE", ONEWIRE_LOOPS_SAMPLE},
+    {"ONEWIRE_LOOPS_SLOT", ONEWIRE_LOOPS_SLOT},
+    {"ONEWIRE_LOOPS_RECOVERY", ONEWIRE_LOOPS_RECOVERY},
+};
+
+#define MAX_OPERANDS (8)
+
+static struct {
+  char name[16];
+  unsigned long value;
+} operands[MAX_OPERANDS];
+static int operand_count;
+
+static char *read_file(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *buf = malloc((size_t)len + 1);
+  if (buf && fread(buf, 1, (size_t)len, f) != (size_t)len) {
+    free(buf);
+    buf = NULL;
+  }
+  if (buf) {
+    buf[len] = '\0';
+  }
+  fclose(f);
+  return buf;
+}
+
+/**
+ * Add one asm line ("label: op args") to the program.
+ */
+static void parse_line(const char *line) {
+  while (*line == ' ') {
+    line++;
+  }
+  if (line[0] >= '1' && line[0] <= '9' && line[1] == ':') {
+    labels[line[0] - '0'] = prog_len;
+    line += 2;
+  }
+  if (prog_len >= MAX_INSNS) {
+    CHECK(0, "asm block too long");
+    return;
+  }
+  insn_t *in = &prog[prog_len++];
+  if (sscanf(line, " %7s %47[^\n]", in->op, in->arg) < 1) {
+    CHECK(0, "cannot parse asm line \"%s\"", line);
+  }
+}
+
+/**
+ * Bind the "n" operands ([n_low] "n"(ONEWIRE_LOOPS_LOW), ...) to values.
+ */
+static void parse_operands(const char *start, const char *end) {
+  const char *p = start;
+
+  while ((p = strstr(p, "\"n\"(")) && p < end) {
+    const char *name = p;
+    while (name > start && *name != '[') {
+      name--;
+    }
+    const char *macro = p + 4;
+    size_t macro_len = strcspn(macro, ")");
+    int found = 0;
+
+    for (size_t i = 0; i < sizeof(loop_macros) / sizeof(loop_macros[0]); i++) {
+      if (strlen(loop_macros[i].macro) == macro_len &&
+          !strncmp(macro, loop_macros[i].macro, macro_len) &&
+          operand_count < MAX_OPERANDS) {
+        size_t len = strcspn(name + 1, "]");
+        if (len >= sizeof(operands[0].name)) {
+          len = sizeof(operands[0].name) - 1;
+        }
+        memcpy(operands[operand_count].name, name + 1, len);
+        operands[operand_count].name[len] = '\0';
+        operands[operand_count].value = loop_macros[i].value;
+        operand_count++;
+        found = 1;
+      }
+    }
+    CHECK(found, "unknown asm operand %.*s", (int)macro_len, macro);
+    p = macro;
+  }
+}
+
+/**
+ * Extract the asm block of onewire_rw_bits() from the source.
+ */
+static int parse_source(const char *src) {
+  const char *func = strstr(src, "uint8_t onewire_rw_bits(");
+  const char *p = func ? strstr(func, "__asm__ __volatile__(") : NULL;
+  const char *end = p ? strstr(p, "\"memory\");") : NULL;
+  const char *code_end = p ? strstr(p, ": [data]") : NULL;
+  if (!end || !code_end) {
+    return 0;
+  }
+
+  while ((p = strchr(p, '"')) && p < code_end) {
+    const char *close = strstr(p + 1, "\\n\\t\"");
+    if (!close || close > code_end) {
+      break;
+    }
+    char line[96];
+    size_t len = (size_t)(close - p - 1);
+    if (len >= sizeof(line)) {
+      len = sizeof(line) - 1;
+    }
+    memcpy(line, p + 1, len);
+    line[len] = '\0';
+    parse_line(line);
+    p = close + 5;
+  }
+
+  parse_operands(code_end, end);
+  return prog_len > 0;
+}
+
+// ---- Model ----
+
+#define MAX_EVENTS (64)
+
+enum { EV_LOW, EV_RELEASE, EV_SAMPLE };
+
+typedef struct {
+  uint8_t type;
+  uint8_t irq; // Interrupts enabled when it happened
+  unsigned long t;
+} event_t;
+
+static event_t events[MAX_EVENTS];
+static int event_count;
+
+static void event(uint8_t type, uint8_t irq, unsigned long t) {
+  if (event_count < MAX_EVENTS) {
+    events[event_count].type = type;
+    events[event_count].irq = irq;
+    events[event_count].t = t;
+    event_count++;
+  }
+}
+
+static unsigned long loop_value(const char *arg) {
+  const char *name = strstr(arg, "%[");
+  if (name) {
+    name += 2;
+    size_t len = strcspn(name, "]");
+    for (int i = 0; i < operand_count; i++) {
+      if (strlen(operands[i].name) == len &&
+          !strncmp(operands[i].name, name, len)) {
+        return strstr(arg, "hi8(") ? (operands[i].value >> 8) & 0xFF
+                                   : operands[i].value & 0xFF;
+      }
+    }
+  }
+  CHECK(0, "ldi with unknown operand \"%s\"", arg);
+  return 0;
+}
+
+/**
+ * Run the asm block once.
+ *
+ * @param data Bits to write, LSB first
+ * @param bits Bits to transfer
+ * @return Total cycles; data read back in *data, events in events[]
+ */
+static unsigned long run(uint8_t *data, uint8_t bits) {
+  unsigned long t = 0;
+  unsigned count = 0;
+  uint8_t zero = 0, skip = 0, irq = 1, saved_irq = 0, driven = 0;
+  int pc = 0, steps = 0;
+
+  event_count = 0;
+  while (pc < prog_len && steps++ < 100000) {
+    const insn_t *in = &prog[pc++];
+    const char *op = in->op;
+
+    if (skip) {
+      skip = 0;
+      t += 1; // Skipped one-word instruction
+      continue;
+    }
+
+    if (!strcmp(op, "in")) {
+      saved_irq = irq;
+      t += 1;
+    } else if (!strcmp(op, "out")) {
+      irq = saved_irq;
+      t += 1;
+    } else if (!strcmp(op, "cli")) {
+      irq = 0;
+      t += 1;
+    } else if (!strcmp(op, "sbi")) {
+      t += 2;
+      driven = 1;
+      event(EV_LOW, irq, t);
+    } else if (!strcmp(op, "cbi")) {
+      t += 2;
+      driven = 0;
+      event(EV_RELEASE, irq, t);
+    } else if (!strcmp(op, "ldi")) {
+      unsigned long v = loop_value(in->arg);
+      count = strstr(in->arg, "%A[") ? (count & 0xFF00) | v
+                                     : (count & 0x00FF) | (v << 8);
+      t += 1;
+    } else if (!strcmp(op, "sbiw")) {
+      count = (count - 1) & 0xFFFF;
+      zero = (count == 0);
+      t += 2;
+    } else if (!strcmp(op, "dec")) {
+      bits--;
+      zero = (bits == 0);
+      t += 1;
+    } else if (!strcmp(op, "brne")) {
+      if (!zero) {
+        pc = labels[in->arg[0] - '0'];
+        t += 2;
+      } else {
+        t += 1;
+      }
+    } else if (!strcmp(op, "sbrc")) {
+      skip = !(*data & 1);
+      t += 1;
+    } else if (!strcmp(op, "sbic")) {
+      event(EV_SAMPLE, irq, t);
+      skip = driven; // Floating bus reads 1
+      t += 1;
+    } else if (!strcmp(op, "lsr")) {
+      *data >>= 1;
+      t += 1;
+    } else if (!strcmp(op, "ori")) {
+      *data |= 0x80;
+      t += 1;
+    } else {
+      CHECK(0, "instruction \"%s\" not modelled", op);
+      t += 1;
+    }
+  }
+
+  return t;
+}
+
+/**
+ * @return Time of the n-th event of a type, -1 if missing
+ */
+static long event_at(uint8_t type, int n) {
+  for (int i = 0; i < event_count; i++) {
+    if (events[i].type == type && n-- == 0) {
+      return (long)events[i].t;
+    }
+  }
+  return -1;
+}
+
+static double us(long cycles) { return cycles * 1e6 / (double)F_CPU; }
+
+// ---- Tests ----
+
+static void test_slot(void) {
+  uint8_t data = 0;
+
+  // Write 0: held low until the end of the slot
+  run(&data, 1);
+  long low = event_at(EV_LOW, 0);
+  long low0_cycles = event_at(EV_RELEASE, 0) - low;
+  double low0 = us(low0_cycles);
+  CHECK(event_at(EV_RELEASE, 1) < 0, "write 0 released twice");
+  for (int i = 0; i < event_count; i++) {
+    CHECK(!events[i].irq, "interrupts enabled during a write-0 slot");
+  }
+
+  // Write 1 / read: released early, sampled, slot end
+  data = 1;
+  unsigned long total = run(&data, 1);
+  double release = us(event_at(EV_RELEASE, 0) - event_at(EV_LOW, 0));
+  double sample = us(event_at(EV_SAMPLE, 0) - event_at(EV_LOW, 0));
+  long slot_cycles = event_at(EV_RELEASE, 1) - event_at(EV_LOW, 0);
+  double slot = us(slot_cycles);
+  for (int i = 0; i < event_count; i++) {
+    CHECK(!events[i].irq, "interrupts enabled during a write-1 slot");
+  }
+
+  // Recovery: from the slot end to the next falling edge
+  data = 0xFF;
+  run(&data, 2);
+  long period = event_at(EV_LOW, 1) - event_at(EV_LOW, 0);
+  double recovery = us(period - slot_cycles);
+
+  printf("1-Wire slot at %lu MHz: release %.2f us, sample %.2f us, "
+         "write-0 low %.2f us, slot %.2f us, recovery %.2f us, bit %.2f us\n",
+         (unsigned long)(F_CPU / 1000000UL), release, sample, low0, slot,
+         recovery, us(period));
+
+  // Standard speed (DS18B20 datasheet): release 1-15 us, sample before
+  // 15 us, write-0 low 60-120 us, slot 60-120 us, recovery 1 us
+  CHECK(release >= 1.0 && release < 15.0, "release %.2f us", release);
+  CHECK(sample > release && sample < 15.0, "sample %.2f us", sample);
+  CHECK(low0 >= 60.0 && low0 <= 120.0, "write-0 low %.2f us", low0);
+  CHECK(slot >= 60.0 && slot <= 120.0, "slot %.2f us", slot);
+  CHECK(recovery >= 1.0, "recovery %.2f us", recovery);
+  CHECK(low >= 0 && total > 0, "no slot found");
+
+#if F_CPU == 16000000UL
+  // Exact cycles: 3.00, 12.875, 61.125 and 3.0625 us
+  long release_cycles = event_at(EV_RELEASE, 0) - event_at(EV_LOW, 0);
+  long sample_cycles = event_at(EV_SAMPLE, 0) - event_at(EV_LOW, 0);
+  CHECK(release_cycles == 48, "release %ld cycles, want 48", release_cycles);
+  CHECK(sample_cycles == 206, "sample %ld cycles, want 206", sample_cycles);
+  CHECK(low0_cycles == 978, "write-0 low %ld cycles, want 978", low0_cycles);
+  CHECK(period - slot_cycles == 49, "recovery %ld cycles, want 49",
+        period - slot_cycles);
+#endif
+}
+
+static void test_loopback(void) {
+  // A floating bus reads back what was written
+  static const uint8_t values[] = {0x00, 0x01, 0x5A, 0xA5, 0x80, 0xFF};
+  for (size_t i = 0; i < sizeof(values); i++) {
+    uint8_t data = values[i];
+    run(&data, 8);
+    CHECK(data == values[i], "wrote %02x, read %02x", values[i], data);
+    CHECK(event_at(EV_SAMPLE, 7) >= 0 && event_at(EV_SAMPLE, 8) < 0,
+          "%02x: not 8 slots", values[i]);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : "src/onewire.c";
+  char *src = read_file(path);
+
+  if (!src || !parse_source(src)) {
+    printf("%s: cannot find the asm block in %s\n", __FILE__, path);
+    free(src);
+    return 1;
+  }
+  free(src);
+  CHECK(operand_count == 4, "%d loop count operands", operand_count);
+
+  test_slot();
+  test_loopback();
+
+  return test_report(__FILE__);
+}
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Host tests and microbenchmarks for the pure hot-path functions:
+ * fan_curve_compute_pwm16(), fan_curve_segment(), uart_print_dec16() and
+ * crc8().
+ *
+ * The fan curve is swept over every int16_t 1/16 °C input and checked
+ * against exact interpolation, for monotonicity and against its segments.
+ * uart_print_dec16() and crc8() are checked against the implementations
+ * they replaced (kept below as ref_*), over every int16_t input or over
+ * known 1-Wire vectors and random buffers. Everything is timed in ns/call. UART output is
+ * captured by sampling the TX pin once per bit time in _delay_us(), so the
+ * real bit-banged uart_send_byte() runs unchanged.
+ *
+ * Build and run with `make test`.
+ */
+
+#include "crc8.h"
+#include "fan_curve.h"
+#include "test_util.h"
+#include "uart.h"
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ---- UART capture ----
+
+static char uart_out[64]; // Bytes decoded from the TX pin
+static uint8_t uart_len;  // Number of bytes in uart_out
+
+static void uart_capture(char c) {
+  if (uart_len < sizeof(uart_out) - 1) {
+    uart_out[uart_len++] = c;
+    uart_out[uart_len] = '\0';
+  }
+}
+
+static void uart_capture_reset(void) {
+  uart_len = 0;
+  uart_out[0] = '\0';
+}
+
+// ---- Reference implementations (before optimisation) ----
+
+// Curve with a falling segment, a flat one and both int8 extremes
+static const fan_curve_point_t test_curve_points[] = {
+    {-128, 40}, {-10, 0}, {0, 255}, {20, 255}, {21, 0}, {127, 128}};
+
+static const fan_curve_t test_curve = {
+    test_curve_points, sizeof(test_curve_points) / sizeof(test_curve_points[0])};
+
+// Division per digit; negates in place, so -32768 prints as "-"
+static void ref_print_dec16(int16_t num) {
+  int i = 8;
+  char negate = 0;
+  char buffer[7];
+  char *ptr = buffer + sizeof(buffer) - 1;
+
+  *ptr-- = '\0';
+
+  if (num == 0) {
+    *ptr-- = '0';
+    goto end;
+  }
+
+  if (num < 0) {
+    negate = 1;
+    num = (int16_t)-num;
+  }
+
+  while (num > 0 && i >= 0) {
+    *ptr-- = (char)((num % 10) + '0');
+    num /= 10;
+  }
+
+  if (negate && i >= 0) {
+    *ptr-- = '-';
+  }
+
+end:
+  ++ptr;
+  uart_print(ptr);
+}
+
+// Bitwise Dallas/Maxim CRC8
+static uint8_t ref_crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t in = *data++;
+    for (uint8_t i = 0; i < 8; i++) {
+      uint8_t mix = (crc ^ in) & 0x01;
+      crc >>= 1;
+      if (mix) {
+        crc ^= 0x8C;
+      }
+      in >>= 1;
+    }
+  }
+  return crc;
+}
+
+// ---- Helpers ----
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void) { // xorshift32, fixed seed for repeatable runs
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile uint32_t sink; // Keeps benchmarked results alive
+
+// ---- Tests ----
+
+/**
+ * Exact duty of a curve at a 1/16 °C temperature, 0-65535 scale.
+ */
+static double exact_duty(const fan_curve_t *curve, int32_t t) {
+  const fan_curve_point_t *p = curve->points;
+  uint8_t last = curve->count - 1;
+
+  if (t < p[0].temperature * 16)
+    return p[0].pwm_duty * 257.0;
+  for (uint8_t i = 0; i < last; i++) {
+    int32_t t1 = p[i].temperature * 16, t2 = p[i + 1].temperature * 16;
+    if (t < t2) {
+      return 257.0 * (p[i].pwm_duty + (double)(t - t1) *
+                                          (p[i + 1].pwm_duty - p[i].pwm_duty) /
+                                          (t2 - t1));
+    }
+  }
+  return p[last].pwm_duty * 257.0;
+}
+
+static void check_curve(const fan_curve_t *curve, uint8_t monotonic) {
+  uint16_t prev = 0;
+
+  for (int32_t t = INT16_MIN; t <= INT16_MAX; t++) {
+    uint16_t got = fan_curve_compute_pwm16(curve, (int16_t)t);
+    double want = exact_duty(curve, t);
+    CHECK(got - want < 1.0 && want - got < 1.0,
+          "fan_curve_compute_pwm16(%d) = %u, want %.2f", (int)t, got, want);
+    if (monotonic && t > INT16_MIN) {
+      CHECK(got >= prev, "fan_curve_compute_pwm16(%d) = %u, below %u", (int)t,
+            got, prev);
+    }
+    prev = got;
+  }
+
+  // Curve points are hit exactly
+  for (uint8_t i = 0; i < curve->count; i++) {
+    int16_t t = (int16_t)(curve->points[i].temperature * 16);
+    CHECK(fan_curve_compute_pwm16(curve, t) ==
+              curve->points[i].pwm_duty * 257U,
+          "fan_curve_compute_pwm16 at point %u", i);
+  }
+}
+
+static void check_segments(const fan_curve_t *curve) {
+  for (int16_t t = INT8_MIN; t <= INT8_MAX; t++) {
+    int8_t low, high;
+    uint8_t flat = fan_curve_segment(curve, (int8_t)t, &low, &high);
+
+    // -128 / 127 are open ends, inclusive
+    CHECK((low < t || low == INT8_MIN) && (t < high || high == INT8_MAX),
+          "segment of %d: %d..%d", t, low, high);
+
+    // Bounds are curve points (or the int8 ends), with none in between
+    for (uint8_t i = 0; i < curve->count; i++) {
+      int8_t pt = curve->points[i].temperature;
+      CHECK(!(pt > low + 1 && pt < high), "segment of %d: %d..%d spans %d",
+            t, low, high, pt);
+    }
+
+    // A flat segment has the same duty everywhere inside, at 1/16 °C
+    if (flat) {
+      uint16_t duty = fan_curve_compute_pwm16(curve, (int16_t)(t * 16));
+      for (int32_t q = (low + 1) * 16; q < high * 16; q++) {
+        if (fan_curve_compute_pwm16(curve, (int16_t)q) != duty) {
+          CHECK(0, "segment of %d: %d..%d not flat at %d/16", t, low, high,
+                (int)q);
+          break;
+        }
+      }
+    } else {
+      CHECK(fan_curve_compute_pwm16(curve, (int16_t)((low + 1) * 16)) !=
+                fan_curve_compute_pwm16(curve, (int16_t)(high * 16 - 1)),
+            "segment of %d: %d..%d reported sloped", t, low, high);
+    }
+  }
+}
+
+static void test_fan_curve(void) {
+  check_curve(&fan_curve_default, 1);
+  check_curve(&test_curve, 0);
+  check_segments(&fan_curve_default);
+  check_segments(&test_curve);
+}
+
+static void test_print_dec16(void) {
+  char want[8];
+
+  for (int32_t n = INT16_MIN; n <= INT16_MAX; n++) {
+    uart_capture_reset();
+    uart_print_dec16((int16_t)n);
+    snprintf(want, sizeof(want), "%d", (int)n);
+    CHECK(strcmp(uart_out, want) == 0, "uart_print_dec16(%d) = \"%s\"",
+          (int)n, uart_out);
+
+    if (n == INT16_MIN) {
+      continue; // The reference gets this one wrong, see below
+    }
+
+    char got[8];
+    strcpy(got, uart_out);
+    uart_capture_reset();
+    ref_print_dec16((int16_t)n);
+    CHECK(strcmp(got, uart_out) == 0, "uart_print_dec16(%d) = \"%s\", ref \"%s\"",
+          (int)n, got, uart_out);
+  }
+
+  // Regression: the old formatter printed "-" for -32768
+  uart_capture_reset();
+  uart_print_dec16(INT16_MIN);
+  CHECK(strcmp(uart_out, "-32768") == 0, "uart_print_dec16(-32768) = \"%s\"",
+        uart_out);
+  uart_capture_reset();
+  ref_print_dec16(INT16_MIN);
+  CHECK(strcmp(uart_out, "-") == 0, "reference no longer shows the bug: \"%s\"",
+        uart_out);
+
+  // Flash strings go through the same sender
+  static const char flash[] PROGMEM = "Prof: irq max=";
+  uart_capture_reset();
+  uart_print_P(flash);
+  CHECK(strcmp(uart_out, "Prof: irq max=") == 0, "uart_print_P() = \"%s\"",
+        uart_out);
+}
+
+static void test_crc8(void) {
+  // Maxim application note 27: ROM code 02 1C B8 01 00 00 00, CRC A2
+  static const uint8_t rom[8] = {0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2};
+  // DS18B20 power-on scratchpad (+85 °C), CRC 1C
+  static const uint8_t pad[9] = {0x50, 0x05, 0x4B, 0x46, 0x7F,
+                                 0xFF, 0x0C, 0x10, 0x1C};
+
+  CHECK(crc8(rom, 7) == 0xA2, "ROM CRC %02x", crc8(rom, 7));
+  CHECK(crc8(rom, 8) == 0, "ROM with CRC does not check to 0");
+  CHECK(crc8(pad, 8) == 0x1C, "scratchpad CRC %02x", crc8(pad, 8));
+  CHECK(crc8(pad, 9) == 0, "scratchpad with CRC does not check to 0");
+  CHECK(crc8(pad, 0) == 0, "empty buffer CRC %02x", crc8(pad, 0));
+
+  for (uint32_t i = 0; i < 0x10000; i++) { // Every 2-byte input
+    uint8_t buf[2] = {(uint8_t)i, (uint8_t)(i >> 8)};
+    CHECK(crc8(buf, 2) == ref_crc8(buf, 2), "crc8(%02x %02x)", buf[0], buf[1]);
+  }
+
+  for (uint32_t i = 0; i < 200000; i++) { // Random buffers of 0-32 bytes
+    uint8_t buf[32];
+    uint8_t len = (uint8_t)(rng() % (sizeof(buf) + 1));
+    for (uint8_t j = 0; j < len; j++) {
+      buf[j] = (uint8_t)rng();
+    }
+    CHECK(crc8(buf, len) == ref_crc8(buf, len), "crc8 random buffer %u",
+          (unsigned)i);
+  }
+}
+
+// ---- Benchmarks ----
+
+static void bench(const char *name, double ns, uint32_t calls) {
+  printf("  %-28s %8.1f ns/call\n", name, ns / calls);
+}
+
+static void bench_all(void) {
+  enum { ROUNDS = 4 };
+  uint8_t buf[9];
+  double t;
+
+  for (uint8_t j = 0; j < sizeof(buf); j++) {
+    buf[j] = (uint8_t)rng();
+  }
+
+  printf("Benchmarks (host; UART bytes still cost 10 stub delay calls):\n");
+
+  t = now_ns();
+  for (int r = 0; r < ROUNDS; r++)
+    for (int32_t v = INT16_MIN; v <= INT16_MAX; v++)
+      sink += fan_curve_compute_pwm16(&fan_curve_default, (int16_t)v);
+  bench("fan_curve_compute_pwm16", now_ns() - t, ROUNDS * 0x10000UL);
+
+  t = now_ns();
+  for (int r = 0; r < ROUNDS * 256; r++)
+    for (int16_t v = INT8_MIN; v <= INT8_MAX; v++) {
+      int8_t low, high;
+      sink += fan_curve_segment(&fan_curve_default, (int8_t)v, &low, &high);
+    }
+  bench("fan_curve_segment", now_ns() - t, ROUNDS * 256 * 256UL);
+
+  test_uart_sink = NULL; // Time only the call
+  t = now_ns();
+  for (int32_t v = INT16_MIN; v <= INT16_MAX; v++) {
+    uart_print_dec16((int16_t)v);
+  }
+  bench("uart_print_dec16", now_ns() - t, 0x10000UL);
+
+  t = now_ns();
+  for (int32_t v = INT16_MIN; v <= INT16_MAX; v++) {
+    ref_print_dec16((int16_t)v);
+  }
+  bench("  reference", now_ns() - t, 0x10000UL);
+  test_uart_sink = uart_capture;
+
+  t = now_ns();
+  for (uint32_t i = 0; i < 1000000; i++) {
+    buf[0] = (uint8_t)i;
+    sink += crc8(buf, sizeof(buf));
+  }
+  bench("crc8 (9-byte scratchpad)", now_ns() - t, 1000000);
+
+  t = now_ns();
+  for (uint32_t i = 0; i < 1000000; i++) {
+    buf[0] = (uint8_t)i;
+    sink += ref_crc8(buf, sizeof(buf));
+  }
+  bench("  reference", now_ns() - t, 1000000);
+}
+
+int main(void) {
+  test_uart_sink = uart_capture;
+  test_fan_curve();
+  test_print_dec16();
+  test_crc8();
+  bench_all();
+
+  return test_report(__FILE__);
+}
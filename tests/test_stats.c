@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Host test of the statistics EEPROM ring: records written one byte per
+ * sample, in chunks copied as their turn comes, must load back at boot
+ * with a valid CRC, and a flush cut short must leave the previous record,
+ * even if the torn slot's CRC happens to match. An all-zero slot must not
+ * load.
+ *
+ * Build and run with `make test`.
+ */
+
+#include "stats.h"
+#include "test_util.h"
+#include "uart.h"
+
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---- EEPROM and UART stubs ----
+
+static uint8_t eeprom[E2END + 1];
+static unsigned eeprom_writes; // Bytes written since the last check
+
+uint8_t eeprom_is_ready(void) { return 1; }
+
+uint8_t eeprom_read_byte(const uint8_t *addr) {
+  return eeprom[(uintptr_t)addr];
+}
+
+uint16_t eeprom_read_word(const uint16_t *addr) {
+  uintptr_t a = (uintptr_t)addr;
+  return (uint16_t)(eeprom[a] | (eeprom[a + 1] << 8));
+}
+
+void eeprom_read_block(void *dst, const void *src, unsigned int len) {
+  memcpy(dst, &eeprom[(uintptr_t)src], len);
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+  eeprom[(uintptr_t)addr] = value;
+  eeprom_writes++;
+}
+
+static char uart_line[256]; // Last "Stats:" line, decoded from the TX pin
+static size_t uart_len;
+
+static void uart_capture(char c) {
+  if (c == '\n') {
+    uart_len = 0;
+  } else if (c != '\r' && uart_len < sizeof(uart_line) - 1 &&
+             (uart_len || c == 'S')) {
+    uart_line[uart_len++] = c;
+    uart_line[uart_len] = '\0';
+  }
+}
+
+// ---- Tests ----
+
+#define RECORD_SIZE (sizeof(stats_record_t))
+#define CRC_POS (offsetof(stats_record_t, crc))
+#define FLUSH_STEPS (CRC_POS + 2) // Invalidate the CRC, body, CRC
+
+/**
+ * Run passes until the next flush has been started and fully written.
+ * Temperatures ramp so that every field keeps changing during the flush.
+ */
+static void run_flush(int16_t *temp) {
+  while (!stats_sample(*temp, 0x8000, 0, 0)) {
+    *temp = (int16_t)(*temp + 1);
+  }
+  eeprom_writes = 0;
+  for (uint8_t i = 0; i < FLUSH_STEPS; i++) {
+    *temp = (int16_t)(*temp + 1);
+    stats_sample(*temp, 0x8000, 0, 0);
+  }
+  CHECK(eeprom_writes == FLUSH_STEPS, "flush wrote %u bytes",
+        eeprom_writes);
+}
+
+/**
+ * Reload the newest record from EEPROM and print it.
+ */
+static void reload(void) {
+  stats_init();
+  stats_report();
+}
+
+static void test_round_trip(void) {
+  int16_t temp = 20 * 16;
+
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  stats_init();
+
+  run_flush(&temp); // Slot 0
+  run_flush(&temp); // Slot 1
+
+  // Both slots hold a record with a good CRC, the second one newer
+  reload();
+  CHECK(strncmp(uart_line, "Stats: samples=", 15) == 0, "report \"%s\"",
+        uart_line);
+  unsigned long samples = strtoul(uart_line + 15, NULL, 10);
+  unsigned long want = 2UL * STATS_FLUSH_INTERVAL; // Second flush start
+  // Fields are copied up to RECORD_SIZE passes after the flush started
+  CHECK(samples >= want && samples <= want + FLUSH_STEPS,
+        "reloaded %lu samples, want about %lu", samples, want);
+
+  // Cut the next flush short: the reload must keep the last full record
+  char before[sizeof(uart_line)];
+  strcpy(before, uart_line);
+  while (!stats_sample(temp, 0x8000, 0, 0)) {
+  }
+  for (uint8_t i = 0; i < FLUSH_STEPS / 2; i++) {
+    stats_sample(temp, 0x8000, 0, 0);
+  }
+  reload();
+  CHECK(strcmp(before, uart_line) == 0, "torn flush loaded \"%s\"",
+        uart_line);
+
+  // A corrupted newest slot falls back to the one before
+  eeprom[RECORD_SIZE + 10] ^= 0x01;
+  reload();
+  samples = strtoul(uart_line + 15, NULL, 10);
+  CHECK(samples < want - STATS_FLUSH_INTERVAL / 2,
+        "corrupt slot not skipped: %lu samples", samples);
+}
+
+/**
+ * CRC8 of a slot as stats_init() checks it, to forge a matching CRC.
+ */
+static uint8_t slot_crc(const uint8_t *slot) {
+  uint8_t crc = 0x5A; // STATS_CRC_INIT
+  for (uint8_t i = 0; i < CRC_POS; i++) {
+    crc ^= slot[i];
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 1) ? (uint8_t)((crc >> 1) ^ 0x8C) : (uint8_t)(crc >> 1);
+    }
+  }
+  return crc;
+}
+
+static void test_torn_flush(void) {
+  int16_t temp = 20 * 16;
+  char before[sizeof(uart_line)];
+
+  // Cut a flush after every step: the previous record must still be the
+  // one loaded. Until seq is written, even if the torn slot's CRC matches
+  // by chance; after that, only the CRC guards the last three steps
+  for (uint8_t cut = 0; cut < FLUSH_STEPS; cut++) {
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    stats_init();
+    run_flush(&temp); // Slot 0
+    run_flush(&temp); // Slot 1
+    reload();
+    strcpy(before, uart_line);
+
+    while (!stats_sample(temp, 0x8000, 0, 0)) {
+    }
+    for (uint8_t i = 0; i < cut; i++) {
+      stats_sample(temp, 0x8000, 0, 0); // Flush step i into slot 2
+    }
+    uint8_t *slot = &eeprom[2 * RECORD_SIZE];
+    if (cut > 0) {
+      CHECK(slot[CRC_POS] != slot_crc(slot),
+            "cut after %u steps: CRC still checks", cut);
+    }
+    if (cut < CRC_POS - 1) {
+      slot[CRC_POS] = slot_crc(slot); // seq not written yet
+    }
+    reload();
+    CHECK(strcmp(before, uart_line) == 0,
+          "cut after %u steps loaded \"%s\", want \"%s\"", cut, uart_line,
+          before);
+  }
+}
+
+static void test_zero_slot(void) {
+  // An all-zero EEPROM must not load as a record with min = max = 0
+  memset(eeprom, 0x00, sizeof(eeprom));
+  stats_init();
+  for (uint8_t i = 0; i < 4; i++) {
+    stats_sample(30 * 16, 0x8000, 0, 0);
+  }
+  stats_report();
+  CHECK(strncmp(uart_line, "Stats: samples=4 min=30 max=30 ", 31) == 0,
+        "all-zero EEPROM loaded: \"%s\"", uart_line);
+}
+
+int main(void) {
+  test_uart_sink = uart_capture;
+  test_round_trip();
+  test_torn_flush();
+  test_zero_slot();
+
+  return test_report(__FILE__);
+}
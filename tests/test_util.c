@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "test_util.h"
+#include "uart.h"
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <util/delay.h>
+
+unsigned test_failures = 0;
+void (*test_uart_sink)(char c) = NULL;
+
+static uint16_t uart_frame; // Bits of the frame being sent, LSB first
+static uint8_t uart_bits;   // Number of bits in uart_frame
+
+int test_report(const char *file) {
+  printf("%s: %u failure(s)\n", file, test_failures);
+  return test_failures ? 1 : 0;
+}
+
+/** One UART bit time: sample TX and pass on every decoded byte. */
+void _delay_us(double us) {
+  (void)us;
+  if (!test_uart_sink) {
+    uart_frame = 0;
+    uart_bits = 0;
+    return;
+  }
+
+  uart_frame |= (uint16_t)((PORTB >> UART_TX_PIN) & 1) << uart_bits;
+  if (++uart_bits < 10) {
+    return;
+  }
+
+  CHECK((uart_frame & 0x201) == 0x200, "bad start / stop bit: %03x",
+        uart_frame);
+  char c = (char)(uart_frame >> 1);
+  uart_frame = 0;
+  uart_bits = 0;
+  test_uart_sink(c);
+}
+
+void _delay_ms(double ms) { (void)ms; }
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 Colahall, LLC.
+ *
+ * This File is part of Tiny85FanControl (see https://colahall.io/).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * “Software”), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef TINY85FANCONTROL_TESTS_TEST_UTIL_H_
+#define TINY85FANCONTROL_TESTS_TEST_UTIL_H_
+
+/**
+ * Helpers shared by the host tests (implemented in tests/test_util.c, which
+ * every test links): failure counting and reporting, and capture of the
+ * bit-banged UART output.
+ */
+
+#include <stdio.h>
+
+/** Number of failed CHECK()s so far. */
+extern unsigned test_failures;
+
+/** Counts a failure when cond is false; prints the first 10 (printf args). */
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      if (test_failures++ < 10) {                                              \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);                            \
+        printf(__VA_ARGS__);                                                   \
+        printf("\n");                                                          \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
+/**
+ * Prints the failure count for file.
+ *
+ * @return the exit status of the test: 0 if nothing failed, else 1
+ */
+int test_report(const char *file);
+
+/**
+ * Receives each byte sent by uart_send_byte(). The _delay_us() stub samples
+ * the TX pin once per bit time and decodes a byte every 10 bits (start, 8
+ * data bits LSB first, stop), so the real bit-banged code runs unchanged.
+ * NULL (the default) skips sampling, e.g. while benchmarking.
+ */
+extern void (*test_uart_sink)(char c);
+
+#endif /* TINY85FANCONTROL_TESTS_TEST_UTIL_H_ */